@@ -25,9 +25,9 @@ int main()
             rec(str, 0);
         }
 
-		cout << "Mem Usage: " << MemPool::Instance()->GetMemUsage() << endl;
-		cout << "Num Used Blocks: " << MemPool::Instance()->GetUsedBlocks() << endl;
-		cout << "Num Unused Blocks: " << MemPool::Instance()->GetUnusedBlocks() << endl;
+		cout << "Mem Usage: " << MemPool::instance()->get_mem_usage() << endl;
+		cout << "Num Used Blocks: " << MemPool::instance()->get_used_blocks() << endl;
+		cout << "Num Unused Blocks: " << MemPool::instance()->get_unused_blocks() << endl;
 
         std::string code;
         std::cout << "sympl> ";
@@ -42,7 +42,7 @@ int main()
 		}
 		if (CodeBuffer->Equals("blocks")) {
 			std::vector<std::string> BlockNames;
-			MemPool::Instance()->GetUsedBlockObjectNames(BlockNames);
+			MemPool::instance()->get_used_block_object_names(BlockNames);
 
 			for (const auto& Name : BlockNames) {
 				cout << Name << endl;
@@ -51,7 +51,7 @@ int main()
 			continue;
 		}
 		if (CodeBuffer->Equals("clrmem")) {
-			MemPool::Instance()->FreeAllBlocks();
+			MemPool::instance()->free_all_blocks();
 			continue;
 		}
 		if (CodeBuffer->Empty()) {
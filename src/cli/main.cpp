@@ -2,9 +2,1170 @@
 using namespace std;
 SymplNamespace
 
-int main()
+// Minimal managed object used by the memory benchmarks.
+class BenchObject : public ManagedObject
 {
-    return 0;
+    SYMPL_OBJECT(BenchObject, ManagedObject)
+
+public:
+    // Payload so the object lands in a realistic size class.
+    long long value = 0;
+
+    BenchObject() = default;
+    explicit BenchObject(long long p_value) : value(p_value) {}
+
+    void __construct(int argc, va_list p_arg_list) override
+    {
+        if (argc > 0) {
+            value = va_arg(p_arg_list, long long);
+        }
+    }
+};
+
+// Two more levels under BenchObject for the type check benchmark.
+class BenchDerived : public BenchObject
+{
+    SYMPL_OBJECT(BenchDerived, BenchObject)
+};
+
+class BenchLeaf : public BenchDerived
+{
+    SYMPL_OBJECT(BenchLeaf, BenchDerived)
+};
+
+// Managed object that can point back at itself through other nodes.
+class CycleNode : public ManagedObject
+{
+    SYMPL_OBJECT(CycleNode, ManagedObject)
+
+public:
+    SharedPtr<CycleNode> next;
+    SharedPtr<BenchObject> payload;
+
+    void __trace(MemCycleTracer& p_tracer) override
+    {
+        p_tracer(next);
+        p_tracer(payload);
+    }
+};
+
+// Release calls made on CountedObject instances.
+static long long counted_release_calls = 0;
+
+// Managed object that counts how often its reference is released.
+class CountedObject : public ManagedObject
+{
+    SYMPL_OBJECT(CountedObject, ManagedObject)
+
+public:
+    int release() override
+    {
+        counted_release_calls++;
+        return ManagedObject::release();
+    }
+};
+
+// Expression tree node walked by the borrowed reference benchmark, like a parsed math script.
+class BenchExprNode : public CountedObject
+{
+    SYMPL_OBJECT(BenchExprNode, CountedObject)
+
+public:
+    // Operator, 0 for a number.
+    char op = 0;
+    long long value = 0;
+    SharedPtr<BenchExprNode> left;
+    SharedPtr<BenchExprNode> right;
+};
+
+// Evaluation state handed down the walk, like the interpreter's context.
+class BenchExprContext : public CountedObject
+{
+    SYMPL_OBJECT(BenchExprContext, CountedObject)
+
+public:
+    long long visits = 0;
+};
+
+// Per-run parser state, leaked by the heap snapshot benchmark like a cache that never evicts.
+class BenchParseContext : public ManagedObject
+{
+    SYMPL_OBJECT(BenchParseContext, ManagedObject)
+
+public:
+    SharedPtr<BenchExprNode> tree;
+    SharedPtr<BenchExprContext> scope;
+};
+
+// Managed object past the large object threshold.
+class BenchLargeObject : public ManagedObject
+{
+    SYMPL_OBJECT(BenchLargeObject, ManagedObject)
+
+public:
+    char payload[96 * 1024];
+};
+
+// Returns the elapsed nanoseconds since the given time point.
+static double elapsed_ns(const std::chrono::high_resolution_clock::time_point& start)
+{
+    auto end = std::chrono::high_resolution_clock::now();
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+// Measures alloc/free pairs against a growing number of live blocks.
+static void bench_pool_alloc()
+{
+    const size_t iterations = 1000000;
+    const size_t live_counts[] = { 2000, 20000, 200000, 2000000 };
+
+    cout << "live_blocks,ns_per_alloc_free" << endl;
+
+    std::vector<SharedPtr<BenchObject>> live;
+    for (size_t live_count : live_counts) {
+        live.reserve(live_count);
+        while (live.size() < live_count) {
+            live.emplace_back(ManagedObject::__new<BenchObject>());
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            auto object = ManagedObject::__new<BenchObject>();
+            object->value = static_cast<long long>(i);
+        }
+
+        cout << live_count << "," << (elapsed_ns(start) / iterations) << endl;
+    }
+}
+
+// Measures alloc/free throughput with one allocating thread per core.
+static void bench_pool_threads()
+{
+    const size_t iterations = 1000000;
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    cout << "threads,million_alloc_free_per_sec" << endl;
+
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([iterations]() {
+                for (size_t i = 0; i < iterations; ++i) {
+                    auto object = ManagedObject::__new<BenchObject>();
+                    object->value = static_cast<long long>(i);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        double total_ops = static_cast<double>(iterations * num_threads);
+        cout << num_threads << "," << (total_ops / elapsed_ns(start) * 1000.0) << endl;
+    }
+}
+
+// Measures pool creation plus the first allocation under different configs.
+static void bench_pool_startup()
+{
+    const size_t runs = 50;
+
+    MemPoolConfig large_config;
+    large_config.initial_reserve_bytes = 64 * 1024 * 1024;
+    large_config.set_prewarm(64, 20000);
+    large_config.set_prewarm(256, 20000);
+    large_config.set_prewarm(1024, 5000);
+
+    MemPoolConfig huge_config = large_config;
+    huge_config.use_huge_pages = true;
+
+    const std::pair<const char*, MemPoolConfig> configs[] = {
+        { "minimal", MemPoolConfig::minimal() },
+        { "default", MemPoolConfig() },
+        { "large", large_config },
+        { "large_huge_pages", huge_config }
+    };
+
+    cout << "config,us_to_first_alloc,us_to_destroy,reserved_bytes" << endl;
+
+    for (const auto& config : configs) {
+        double create_ns = 0;
+        double destroy_ns = 0;
+        size_t reserved_bytes = 0;
+
+        for (size_t i = 0; i < runs; ++i) {
+            auto start = std::chrono::high_resolution_clock::now();
+            auto pool = new MemPool(config.second);
+            pool->create_block(sizeof(BenchObject));
+            create_ns += elapsed_ns(start);
+            reserved_bytes = pool->get_reserved_bytes();
+
+            start = std::chrono::high_resolution_clock::now();
+            delete pool;
+            destroy_ns += elapsed_ns(start);
+        }
+
+        cout << config.first << "," << (create_ns / runs / 1000.0) << "," << (destroy_ns / runs / 1000.0) << "," << reserved_bytes << endl;
+    }
+}
+
+// Passes a shared pointer back up through a few calls by value.
+static SharedPtr<ManagedObject> pass_through(SharedPtr<CountedObject> p_object, int p_depth)
+{
+    if (p_depth == 0) {
+        return p_object;
+    }
+    return pass_through(std::move(p_object), p_depth - 1);
+}
+
+// Counts refcount releases made while shared pointers are moved around.
+static void bench_shared_ptr_moves()
+{
+    const size_t num_objects = 100000;
+
+    cout << "scenario,release_calls,ns_per_object" << endl;
+
+    std::vector<SharedPtr<CountedObject>> objects;
+    counted_release_calls = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < num_objects; ++i) {
+        objects.push_back(ManagedObject::__new<CountedObject>());
+    }
+    cout << "vector_growth," << counted_release_calls << "," << (elapsed_ns(start) / num_objects) << endl;
+
+    std::vector<SharedPtr<ManagedObject>> returned;
+    returned.reserve(num_objects);
+    counted_release_calls = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (auto& object : objects) {
+        returned.push_back(pass_through(object, 4));
+    }
+    cout << "return_by_value," << counted_release_calls << "," << (elapsed_ns(start) / num_objects) << endl;
+
+    counted_release_calls = 0;
+    start = std::chrono::high_resolution_clock::now();
+    objects.clear();
+    returned.clear();
+    cout << "teardown," << counted_release_calls << "," << (elapsed_ns(start) / num_objects) << endl;
+}
+
+// Builds a balanced tree of + and * over small numbers.
+static SharedPtr<BenchExprNode> build_expr(int p_depth, long long& r_next_value)
+{
+    auto node = ManagedObject::make<BenchExprNode>();
+    if (p_depth == 0) {
+        node->value = r_next_value++ % 7 + 1;
+        return node;
+    }
+
+    node->op = (p_depth & 1) ? '+' : '*';
+    node->left = build_expr(p_depth - 1, r_next_value);
+    node->right = build_expr(p_depth - 1, r_next_value);
+    return node;
+}
+
+// Evaluates a tree passing node and context by value, a reference count round trip per call.
+static long long eval_owned(SharedPtr<BenchExprNode> p_node, SharedPtr<BenchExprContext> p_context)
+{
+    p_context->visits++;
+    if (!p_node->op) {
+        return p_node->value;
+    }
+
+    long long left = eval_owned(p_node->left, p_context);
+    long long right = eval_owned(p_node->right, p_context);
+    return (p_node->op == '+' ? left + right : left * right) % 1000003;
+}
+
+// Evaluates a tree passing node and context by borrow.
+static long long eval_borrowed(Ref<BenchExprNode> p_node, Ref<BenchExprContext> p_context)
+{
+    p_context->visits++;
+    if (!p_node->op) {
+        return p_node->value;
+    }
+
+    long long left = eval_borrowed(p_node->left, p_context);
+    long long right = eval_borrowed(p_node->right, p_context);
+    return (p_node->op == '+' ? left + right : left * right) % 1000003;
+}
+
+// Counts refcount releases made walking an expression tree with owned and borrowed arguments.
+static void bench_borrowed_refs()
+{
+    const int depth = 16;
+    const size_t rounds = 20;
+
+    long long next_value = 0;
+    SharedPtr<BenchExprNode> root = build_expr(depth, next_value);
+    auto context = ManagedObject::make<BenchExprContext>();
+
+    cout << "convention,release_calls_per_node,ns_per_node,result" << endl;
+
+    const std::pair<const char*, bool> conventions[] = { { "owned", false }, { "borrowed", true } };
+    for (const auto& convention : conventions) {
+        long long result = 0;
+        context->visits = 0;
+        counted_release_calls = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t round = 0; round < rounds; ++round) {
+            result = convention.second ? eval_borrowed(root, context) : eval_owned(root, context);
+        }
+        auto visits = static_cast<double>(context->visits);
+        cout << convention.first << "," << (static_cast<double>(counted_release_calls) / visits) << ","
+             << (elapsed_ns(start) / visits) << "," << result << endl;
+    }
+}
+
+// Creates, runs and drops sandbox VMs on the global heap, on a heap each, and on one recycled heap.
+static void bench_vm_heaps()
+{
+    const size_t num_vms = 200;
+    const int depth = 12;
+
+    cout << "heap,us_to_build,us_to_run,us_to_drop,release_calls_to_drop" << endl;
+
+    enum class VMHeap { Shared, PerVM, Recycled };
+    const std::pair<const char*, VMHeap> heaps[] = {
+        { "shared", VMHeap::Shared },
+        { "per_vm", VMHeap::PerVM },
+        { "recycled", VMHeap::Recycled }
+    };
+
+    MemPool recycled_pool(MemPoolConfig::minimal());
+    for (const auto& heap : heaps) {
+        double build_ns = 0;
+        double run_ns = 0;
+        double drop_ns = 0;
+        long long release_calls = 0;
+
+        for (size_t vm = 0; vm < num_vms; ++vm) {
+            long long next_value = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            MemPool* pool = MemPool::instance();
+            if (heap.second == VMHeap::PerVM) {
+                pool = new MemPool(MemPoolConfig::minimal());
+            } else if (heap.second == VMHeap::Recycled) {
+                pool = &recycled_pool;
+            }
+
+            SharedPtr<BenchExprNode> root;
+            SharedPtr<BenchExprContext> context;
+            {
+                MemPoolScope scope(pool);
+                root = build_expr(depth, next_value);
+                context = ManagedObject::make<BenchExprContext>();
+            }
+            build_ns += elapsed_ns(start);
+
+            start = std::chrono::high_resolution_clock::now();
+            eval_borrowed(root, context);
+            run_ns += elapsed_ns(start);
+
+            counted_release_calls = 0;
+            start = std::chrono::high_resolution_clock::now();
+            if (heap.second == VMHeap::Shared) {
+                root = SharedPtr<BenchExprNode>();
+                context = SharedPtr<BenchExprContext>();
+            } else {
+                // The VM's roots go down with its heap.
+                root.detach();
+                context.detach();
+                if (heap.second == VMHeap::PerVM) {
+                    delete pool;
+                } else {
+                    pool->free_all_blocks();
+                }
+            }
+            drop_ns += elapsed_ns(start);
+            release_calls += counted_release_calls;
+        }
+
+        cout << heap.first << "," << (build_ns / num_vms / 1000.0) << "," << (run_ns / num_vms / 1000.0) << ","
+             << (drop_ns / num_vms / 1000.0) << "," << (release_calls / static_cast<long long>(num_vms)) << endl;
+    }
+}
+
+// Runs frames of short-lived temporaries on the heap and in a scratch arena, promoting one value per frame.
+static void bench_scratch()
+{
+    const size_t frames = 2000;
+    const size_t temporaries = 1000;
+
+    MemScratchArena arena;
+    std::vector<SharedPtr<BenchObject>> globals(64);
+
+    cout << "allocator,ns_per_temporary,ns_per_reset,peak_scratch_bytes" << endl;
+
+    const std::pair<const char*, bool> allocators[] = { { "heap", false }, { "scratch", true } };
+    for (const auto& allocator : allocators) {
+        double frame_ns = 0;
+        double reset_ns = 0;
+        long long sum = 0;
+
+        for (size_t frame = 0; frame < frames; ++frame) {
+            auto start = std::chrono::high_resolution_clock::now();
+            {
+                MemScratchScope scope(allocator.second ? &arena : nullptr);
+                SharedPtr<BenchObject> last;
+                for (size_t i = 0; i < temporaries; i += 2) {
+                    auto left = ManagedObject::make_scratch<BenchObject>(static_cast<long long>(i));
+                    last = ManagedObject::make_scratch<BenchObject>(left->value * 2);
+                    sum += last->value;
+                }
+
+                // Stored past the frame, like a value assigned to a global.
+                globals[frame & 63] = ManagedObject::promote(last);
+            }
+            frame_ns += elapsed_ns(start);
+
+            start = std::chrono::high_resolution_clock::now();
+            arena.reset();
+            reset_ns += elapsed_ns(start);
+        }
+
+        cout << allocator.first << "," << (frame_ns / (frames * temporaries)) << "," << (reset_ns / frames) << ","
+             << arena.get_peak_bytes() << endl;
+        if (sum == 0) {
+            cout << "checksum,0" << endl;
+        }
+    }
 }
 
+// Drops a large graph inline and through the deferred release queue, reporting the longest pause.
+static void bench_deferred_release()
+{
+    const int depth = 19;
+    MemReleaseQueue* queue = MemReleaseQueue::instance();
+
+    cout << "mode,objects,max_pause_us,total_ms,slices,peak_depth" << endl;
+
+    const std::pair<const char*, bool> modes[] = { { "inline", false }, { "deferred", true } };
+    for (const auto& mode : modes) {
+        long long next_value = 0;
+        SharedPtr<BenchExprNode> root = build_expr(depth, next_value);
+        queue->set_enabled(mode.second);
+
+        counted_release_calls = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        root = SharedPtr<BenchExprNode>();
+        double max_pause_ns = elapsed_ns(start);
+        double total_ns = max_pause_ns;
+
+        // One safe point per frame until the graph is gone.
+        size_t slices = 0;
+        while (queue->get_depth() > 0) {
+            queue->safe_point();
+            slices++;
+            max_pause_ns = std::max(max_pause_ns, static_cast<double>(queue->get_last_drain_ns()));
+            total_ns += static_cast<double>(queue->get_last_drain_ns());
+        }
+
+        cout << mode.first << "," << counted_release_calls << "," << (max_pause_ns / 1000.0) << ","
+             << (total_ns / 1000000.0) << "," << slices << "," << queue->get_peak_depth() << endl;
+        queue->set_enabled(false);
+    }
+}
+
+// Makes a string per token of a script, with the buffer inside the object and with a heap buffer per string.
+static void bench_strings()
+{
+    const size_t num_strings = 1000000;
+    const char* tokens[] = { "x", "count", "42", "+", "print", "(", "while", "3.14159", "\"hello world\"", "long_variable_name_past_inline" };
+    const size_t num_tokens = sizeof(tokens) / sizeof(tokens[0]);
+
+    cout << "mode,strings,inline_strings,bytes_per_string,ns_per_string" << endl;
+
+    const std::pair<const char*, size_t> modes[] = { { "inline", SYMPL_STRING_BUFFER_INLINE_CAPACITY }, { "heap", SYMPL_STRING_BUFFER_CAPACITY } };
+    for (const auto& mode : modes) {
+        std::vector<SharedPtr<StringBuffer>> strings;
+        strings.reserve(num_strings);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < num_strings; ++i) {
+            strings.emplace_back(ManagedObject::make<StringBuffer>(tokens[i % num_tokens], mode.second));
+        }
+        double elapsed = elapsed_ns(start);
+
+        // Pool block plus the buffer, if the string needed one.
+        size_t inline_strings = 0;
+        size_t bytes = 0;
+        for (const auto& string : strings) {
+            bytes += string->mem_block->block_size;
+            if (string->is_inline()) {
+                inline_strings++;
+            } else {
+                bytes += string->capacity();
+            }
+        }
+
+        cout << mode.first << "," << num_strings << "," << inline_strings << ","
+             << (static_cast<double>(bytes) / num_strings) << "," << (elapsed / num_strings) << endl;
+    }
+}
+
+// Builds strings out of small appends, growing as needed, reserved up front and through std::string.
+static void bench_append()
+{
+    const char* pieces[] = { "let ", "x", " = ", "42", ";\n" };
+    const size_t num_pieces = sizeof(pieces) / sizeof(pieces[0]);
+    const size_t lengths[] = { 1000, 100000, 10000000 };
+
+    cout << "mode,length,capacity,ns_per_string" << endl;
+
+    for (size_t target : lengths) {
+        size_t rounds = std::max(static_cast<size_t>(1), std::min(static_cast<size_t>(2000), 20000000 / target));
+
+        size_t length = 0;
+        size_t capacity = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t round = 0; round < rounds; ++round) {
+            SharedPtr<StringBuffer> string = ManagedObject::make<StringBuffer>();
+            for (size_t i = 0; string->length() < target; ++i) {
+                string->append(pieces[i % num_pieces]);
+            }
+            length = string->length();
+            capacity = string->capacity();
+        }
+        cout << "grow," << length << "," << capacity << "," << (elapsed_ns(start) / rounds) << endl;
 
+        start = std::chrono::high_resolution_clock::now();
+        for (size_t round = 0; round < rounds; ++round) {
+            SharedPtr<StringBuffer> string = ManagedObject::make<StringBuffer>();
+            string->reserve(target + 8);
+            for (size_t i = 0; string->length() < target; ++i) {
+                string->append(pieces[i % num_pieces]);
+            }
+            length = string->length();
+            capacity = string->capacity();
+        }
+        cout << "reserve," << length << "," << capacity << "," << (elapsed_ns(start) / rounds) << endl;
+
+        start = std::chrono::high_resolution_clock::now();
+        for (size_t round = 0; round < rounds; ++round) {
+            std::string string;
+            for (size_t i = 0; string.length() < target; ++i) {
+                string.append(pieces[i % num_pieces]);
+            }
+            length = string.length();
+            capacity = string.capacity();
+        }
+        cout << "std_string," << length << "," << capacity << "," << (elapsed_ns(start) / rounds) << endl;
+    }
+
+    // Prepending shifts the string in place instead of copying it into a new buffer.
+    const size_t prepends = 2000;
+    auto start = std::chrono::high_resolution_clock::now();
+    SharedPtr<StringBuffer> string = ManagedObject::make<StringBuffer>();
+    for (size_t i = 0; i < prepends; ++i) {
+        string->prepend("ab");
+    }
+    cout << "prepend," << string->length() << "," << string->capacity() << "," << elapsed_ns(start) << endl;
+}
+
+// Runs a script loop that leaks a parse context every few runs and finds it by diffing two heap snapshots.
+static void bench_heap_snapshot()
+{
+    const size_t runs = 10000;
+    const size_t leak_every = 10;
+    MemPool* pool = MemPool::instance();
+
+    // Live objects from the rest of the program, so the walk has something to wade through.
+    std::vector<SharedPtr<BenchObject>> background;
+    for (size_t i = 0; i < 500000; ++i) {
+        background.emplace_back(ManagedObject::make<BenchObject>(static_cast<long long>(i)));
+    }
+
+    std::vector<SharedPtr<BenchParseContext>> leaked;
+    long long sum = 0;
+    auto run_script = [&leaked, &sum](size_t p_run) {
+        long long next_value = static_cast<long long>(p_run);
+        SharedPtr<BenchParseContext> context = ManagedObject::make<BenchParseContext>();
+        context->tree = build_expr(4, next_value);
+        context->scope = ManagedObject::make<BenchExprContext>();
+        sum += eval_borrowed(context->tree, context->scope);
+        if (p_run % leak_every == 0) {
+            leaked.emplace_back(context);
+        }
+    };
+
+    cout << "step,blocks,ms" << endl;
+
+    MemHeapSnapshot before;
+    auto start = std::chrono::high_resolution_clock::now();
+    before.take(pool);
+    cout << "snapshot_before," << before.get_num_blocks() << "," << (elapsed_ns(start) / 1000000.0) << endl;
+
+    for (size_t run = 1; run <= runs; ++run) {
+        run_script(run);
+    }
+
+    MemHeapSnapshot after;
+    start = std::chrono::high_resolution_clock::now();
+    after.take(pool);
+    cout << "snapshot_after," << after.get_num_blocks() << "," << (elapsed_ns(start) / 1000000.0) << endl;
+
+    std::vector<MemHeapTypeDelta> deltas;
+    start = std::chrono::high_resolution_clock::now();
+    MemHeapSnapshot::diff(before, after, deltas);
+    cout << "diff," << deltas.size() << "," << (elapsed_ns(start) / 1000000.0) << endl;
+
+    MemHeapSnapshot::write_diff(deltas, 5, cout);
+    cout << "checksum," << sum << endl;
+}
+
+// Clears and refills one heap far more times than the block table has segments,
+// checking that allocation keeps working and handles from earlier fills go stale.
+static void bench_pool_clears()
+{
+    const size_t cycles = 10000;
+    const size_t objects_per_cycle = 100;
+    MemPool pool(MemPoolConfig::minimal());
+
+    size_t failed_cycles = 0;
+    size_t stale_resolved = 0;
+    MemHandle stale_handle;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t cycle = 0; cycle < cycles; ++cycle) {
+        MemPoolScope scope(&pool);
+        std::vector<SharedPtr<BenchObject>> objects;
+        for (size_t i = 0; i < objects_per_cycle; ++i) {
+            objects.emplace_back(ManagedObject::make<BenchObject>(static_cast<long long>(i)));
+        }
+        if (!objects.front().ptr() || !objects.back().ptr()) {
+            failed_cycles++;
+        }
+
+        // The new blocks reuse the indices of the last fill.
+        if (pool.is_alive(stale_handle)) {
+            stale_resolved++;
+        }
+        stale_handle = objects.front()->get_handle();
+
+        for (auto& object : objects) {
+            object.detach();
+        }
+        pool.clear();
+    }
+
+    cout << "cycles,failed_cycles,stale_resolved,us_per_cycle" << endl;
+    cout << cycles << "," << failed_cycles << "," << stale_resolved << "," << (elapsed_ns(start) / cycles / 1000.0) << endl;
+}
+
+// Measures liveness checks through handles and weak pointers while half the objects are freed and reused.
+static void bench_handles()
+{
+    const size_t num_objects = 1000000;
+
+    std::vector<SharedPtr<BenchObject>> objects;
+    std::vector<MemHandle> handles;
+    std::vector<WeakPtr<BenchObject>> weak_ptrs;
+    objects.reserve(num_objects);
+    handles.reserve(num_objects);
+    weak_ptrs.reserve(num_objects);
+
+    for (size_t i = 0; i < num_objects; ++i) {
+        objects.emplace_back(ManagedObject::__new<BenchObject>());
+        handles.emplace_back(objects.back()->get_handle());
+        weak_ptrs.emplace_back(objects.back());
+    }
+
+    // Free every other object and hand its block straight back out.
+    for (size_t i = 0; i < num_objects; i += 2) {
+        objects[i] = ManagedObject::__new<BenchObject>();
+    }
+
+    cout << "check,alive,ns_per_check" << endl;
+
+    MemPool* pool = MemPool::instance();
+    size_t alive = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto& handle : handles) {
+        alive += pool->is_alive(handle) ? 1 : 0;
+    }
+    cout << "handle," << alive << "," << (elapsed_ns(start) / num_objects) << endl;
+
+    alive = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (const auto& weak_ptr : weak_ptrs) {
+        alive += weak_ptr.is_valid() ? 1 : 0;
+    }
+    cout << "weak_ptr," << alive << "," << (elapsed_ns(start) / num_objects) << endl;
+}
+
+// Builds and drops reference cycles in a loop, collecting at a safe point per iteration.
+static void bench_cycles()
+{
+    const size_t iterations = 5000000;
+    const size_t report_every = 500000;
+
+    MemPool* pool = MemPool::instance();
+    MemCycleCollector* collector = MemCycleCollector::instance();
+
+    // Live object every other ring points at, it has to survive the collections of those rings.
+    auto shared = ManagedObject::__new<BenchObject>();
+
+    cout << "iteration,live_blocks,mem_usage,collections,freed,max_pause_us,overruns" << endl;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 1; i <= iterations; ++i) {
+        // Three node ring holding a leaf object, unreachable as soon as the locals go.
+        auto first = ManagedObject::__new<CycleNode>();
+        auto second = ManagedObject::__new<CycleNode>();
+        auto third = ManagedObject::__new<CycleNode>();
+        first->next = second;
+        second->next = third;
+        third->next = first;
+        first->payload = ManagedObject::__new<BenchObject>();
+        if (i % 2 == 0) {
+            second->payload = shared;
+        }
+
+        first = SharedPtr<CycleNode>();
+        second = SharedPtr<CycleNode>();
+        third = SharedPtr<CycleNode>();
+        collector->safe_point();
+
+        if (i % report_every == 0) {
+            cout << i << "," << pool->get_used_blocks() << "," << pool->get_mem_usage() << ","
+                 << collector->get_num_collections() << "," << collector->get_num_freed() << ","
+                 << (collector->get_max_pause_ns() / 1000.0) << "," << collector->get_num_overruns() << endl;
+        }
+    }
+    double ns = elapsed_ns(start);
+
+    collector->collect();
+    cout << "final," << pool->get_used_blocks() << "," << pool->get_mem_usage() << ","
+         << collector->get_num_collections() << "," << collector->get_num_freed() << ","
+         << (collector->get_max_pause_ns() / 1000.0) << "," << collector->get_num_overruns() << endl;
+    cout << "shared_ref_count," << shared.ref_count() << endl;
+    cout << "ns_per_iteration," << (ns / iterations) << endl;
+}
+
+// Reconstructs an object through the varargs hook, the way alloc() does.
+static void construct_varargs(ManagedObject* p_object, int argc, ...)
+{
+    va_list arg_list;
+    va_start(arg_list, argc);
+    p_object->__construct(argc, arg_list);
+    va_end(arg_list);
+}
+
+// Compares default construction plus a varargs reconstruct against constructing in place.
+static void bench_make()
+{
+    const size_t iterations = 2000000;
+    long long checksum = 0;
+
+    cout << "path,ns_per_object" << endl;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        auto object = ManagedObject::__new<BenchObject>();
+        construct_varargs(object.ptr(), 1, static_cast<long long>(i));
+        checksum += object->value;
+    }
+    cout << "new_then_construct," << (elapsed_ns(start) / iterations) << endl;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        auto object = ManagedObject::make<BenchObject>(static_cast<long long>(i));
+        checksum -= object->value;
+    }
+    cout << "make," << (elapsed_ns(start) / iterations) << endl;
+
+    sympl_assert(checksum == 0);
+}
+
+// Compares type checks through ids against RTTI and type name strings.
+static void bench_type_checks()
+{
+    const size_t num_objects = 1024;
+    const size_t rounds = 5000;
+
+    std::vector<SharedPtr<ObjectRef>> objects;
+    for (size_t i = 0; i < num_objects; ++i) {
+        switch (i % 3) {
+            case 0: objects.emplace_back(ManagedObject::make<BenchObject>()); break;
+            case 1: objects.emplace_back(ManagedObject::make<BenchDerived>()); break;
+            default: objects.emplace_back(ManagedObject::make<BenchLeaf>()); break;
+        }
+    }
+
+    const double checks = static_cast<double>(num_objects * rounds);
+    size_t matches = 0;
+
+    cout << "check,matches,ns_per_check" << endl;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (auto& object : objects) {
+            matches += dynamic_cast<BenchDerived*>(object.ptr()) ? 1 : 0;
+        }
+    }
+    cout << "dynamic_cast," << matches << "," << (elapsed_ns(start) / checks) << endl;
+
+    matches = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (auto& object : objects) {
+            matches += ObjectRef::cast_to<BenchDerived>(object.ptr()) ? 1 : 0;
+        }
+    }
+    cout << "cast_to," << matches << "," << (elapsed_ns(start) / checks) << endl;
+
+    matches = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (auto& object : objects) {
+            matches += object->get_type_info()->is_type_of("BenchDerived") ? 1 : 0;
+        }
+    }
+    cout << "type_name," << matches << "," << (elapsed_ns(start) / checks) << endl;
+}
+
+// Returns the resident set size of the process in bytes, 0 where it can't be read.
+static size_t resident_bytes()
+{
+    size_t pages = 0;
+    size_t resident_pages = 0;
+    std::ifstream statm("/proc/self/statm");
+    if (!(statm >> pages >> resident_pages)) {
+        return 0;
+    }
+    return resident_pages * 4096;
+}
+
+// Spikes to a large live set, frees it, and shows resident memory with and without trimming.
+static void bench_trim()
+{
+    const size_t spike_objects = 1000000;
+    MemPool* pool = MemPool::instance();
+
+    // Block headers and table segments are not trimmed, so RSS settles at the metadata of the peak heap.
+    cout << "phase,live_blocks,free_resident_bytes,purged_bytes,metadata_bytes,rss_bytes" << endl;
+    auto report = [pool](const char* p_phase) {
+        cout << p_phase << "," << pool->get_used_blocks() << "," << pool->get_free_resident_bytes() << ","
+             << pool->get_purged_bytes() << "," << pool->get_metadata_bytes() << "," << resident_bytes() << endl;
+    };
+
+    report("start");
+
+    std::vector<SharedPtr<BenchObject>> objects;
+    objects.reserve(spike_objects);
+    for (size_t i = 0; i < spike_objects; ++i) {
+        objects.emplace_back(ManagedObject::make<BenchObject>(static_cast<long long>(i)));
+    }
+    report("spike");
+
+    objects.clear();
+    report("freed");
+
+    pool->trim();
+    report("trimmed");
+
+    // With a policy the pool keeps at most 8 MB of free memory around by itself.
+    pool->set_trim_policy(8 * 1024 * 1024, 2 * 1024 * 1024);
+    for (size_t i = 0; i < spike_objects; ++i) {
+        objects.emplace_back(ManagedObject::make<BenchObject>(static_cast<long long>(i)));
+    }
+    report("policy_spike");
+
+    objects.clear();
+    report("policy_freed");
+    pool->set_trim_policy(0, 0);
+
+    // Dropping every block keeps the trimmed pages given back.
+    pool->trim();
+    pool->free_all_blocks();
+    report("free_all_blocks");
+
+    cout << "note,metadata_bytes stay resident after a trim, only clear() drops them" << endl;
+}
+
+// Churns large objects and string buffers alongside small objects, and shows the large ones leave nothing behind.
+static void bench_large_objects()
+{
+    const size_t rounds = 2000;
+    const size_t batch = 8;
+    const size_t string_bytes = 128 * 1024;
+    MemPool* pool = MemPool::instance();
+
+    cout << "phase,large_objects,large_bytes,reserved_bytes,rss_bytes" << endl;
+    auto report = [pool](const char* p_phase) {
+        cout << p_phase << "," << pool->get_large_object_count() << "," << pool->get_large_object_bytes() << ","
+             << pool->get_reserved_bytes() << "," << resident_bytes() << endl;
+    };
+
+    report("start");
+
+    std::vector<SharedPtr<BenchObject>> small_objects;
+    std::vector<SharedPtr<BenchLargeObject>> large_objects;
+    std::string chunk(1024, 'x');
+    size_t peak_large_bytes = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < batch; ++i) {
+            small_objects.emplace_back(ManagedObject::make<BenchObject>(static_cast<long long>(i)));
+            large_objects.emplace_back(ManagedObject::make<BenchLargeObject>());
+        }
+
+        // Grows through the resize path until the buffer is mapped by itself.
+        auto text = ManagedObject::make<StringBuffer>();
+        while (text->length() < string_bytes) {
+            text->append(chunk.c_str());
+        }
+
+        peak_large_bytes = std::max(peak_large_bytes, pool->get_large_object_bytes());
+        large_objects.clear();
+    }
+    double elapsed = elapsed_ns(start);
+
+    report("churned");
+    small_objects.clear();
+    report("freed");
+
+    cout << "peak_large_bytes," << peak_large_bytes << endl;
+    cout << "ns_per_large_object," << (elapsed / static_cast<double>(rounds * batch)) << endl;
+}
+
+// Walks a heap of live and freed blocks through the metadata arrays and through the block headers.
+static void bench_heap_walk()
+{
+    const size_t num_objects = 1000000;
+    const size_t rounds = 20;
+    MemPool* pool = MemPool::instance();
+
+    std::vector<SharedPtr<ObjectRef>> objects;
+    objects.reserve(num_objects);
+    for (size_t i = 0; i < num_objects; ++i) {
+        switch (i % 3) {
+            case 0: objects.emplace_back(ManagedObject::make<BenchObject>()); break;
+            case 1: objects.emplace_back(ManagedObject::make<BenchDerived>()); break;
+            default: objects.emplace_back(ManagedObject::make<BenchLeaf>()); break;
+        }
+    }
+
+    // Free every other object so the live blocks are spread over the whole heap.
+    for (size_t i = 1; i < num_objects; i += 2) {
+        objects[i] = SharedPtr<ObjectRef>();
+    }
+
+    cout << "walk,live_blocks,ns_per_walk" << endl;
+
+    size_t live_blocks = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        live_blocks = pool->count_live_blocks();
+    }
+    cout << "live_flags," << live_blocks << "," << (elapsed_ns(start) / rounds) << endl;
+
+    std::vector<size_t> counts;
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        counts.assign(counts.size(), 0);
+        live_blocks = pool->count_live_types(counts);
+    }
+    cout << "type_id_array," << live_blocks << "," << (elapsed_ns(start) / rounds) << endl;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        counts.assign(counts.size(), 0);
+        live_blocks = 0;
+        pool->for_each_live_block([&counts, &live_blocks](MemBlock* p_block) {
+            const ObjectRefInfo* type_info = p_block->get_type_info();
+            counts[type_info ? type_info->get_type_id() : 0]++;
+            live_blocks++;
+        });
+    }
+    cout << "block_headers," << live_blocks << "," << (elapsed_ns(start) / rounds) << endl;
+}
+
+// Boxes loop counters and comparison results per iteration, fresh and from immortal objects.
+static void bench_immortals()
+{
+    const size_t iterations = 10000000;
+    MemPool* pool = MemPool::instance();
+
+    SharedPtr<BenchObject> true_value = ManagedObject::make_immortal<BenchObject>(1);
+    SharedPtr<BenchObject> false_value = ManagedObject::make_immortal<BenchObject>(0);
+    MemImmortalCache<BenchObject> small_ints(SYMPL_IMMORTAL_INT_MIN, SYMPL_IMMORTAL_INT_MAX);
+
+    cout << "scenario,allocations,ns_per_iteration" << endl;
+
+    long long sum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        auto value = static_cast<long long>(i % (SYMPL_IMMORTAL_INT_MAX + 1));
+        SharedPtr<BenchObject> counter = ManagedObject::make<BenchObject>(value);
+        SharedPtr<BenchObject> below = ManagedObject::make<BenchObject>(counter->value < 512 ? 1 : 0);
+        sum += below->value;
+    }
+    cout << "fresh," << (iterations * 2) << "," << (elapsed_ns(start) / iterations) << endl;
+
+    size_t live_blocks = pool->count_live_blocks();
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        auto value = static_cast<long long>(i % (SYMPL_IMMORTAL_INT_MAX + 1));
+        SharedPtr<BenchObject> counter(small_ints.get(value));
+        SharedPtr<BenchObject> below = counter->value < 512 ? true_value : false_value;
+        sum += below->value;
+    }
+    cout << "immortal," << (pool->count_live_blocks() - live_blocks) << "," << (elapsed_ns(start) / iterations) << endl;
+
+    // Reference traffic alone, on an object that counts and on one that doesn't.
+    SharedPtr<BenchObject> mortal = ManagedObject::make<BenchObject>(1);
+    std::vector<SharedPtr<BenchObject>> copies(64);
+    for (const auto& source : { mortal, true_value }) {
+        start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            copies[i & 63] = source;
+        }
+        cout << (source->is_immortal() ? "copy_immortal," : "copy_mortal,") << 0 << "," << (elapsed_ns(start) / iterations) << endl;
+        copies.assign(copies.size(), SharedPtr<BenchObject>());
+    }
+
+    cout << "immortal_blocks," << pool->count_static_blocks() << endl;
+    cout << "checksum," << sum << endl;
+}
+
+// Prints the pool counters and the per-type usage table.
+static void print_mem_stats()
+{
+    MemPool* pool = MemPool::instance();
+
+    cout << "Mem Usage: " << pool->get_mem_usage() << endl;
+    cout << "Num Used Blocks: " << pool->get_used_blocks() << endl;
+    cout << "Num Unused Blocks: " << pool->get_unused_blocks() << endl;
+    cout << "Reserved Bytes: " << pool->get_reserved_bytes() << endl;
+
+    std::vector<MemTypeUsage> type_usage;
+    pool->get_type_usage(type_usage);
+
+    cout << "type,live_count,live_bytes,peak_count" << endl;
+    for (const auto& usage : type_usage) {
+        cout << usage.type_info->get_type_name() << "," << usage.live_count << "," << usage.live_bytes << "," << usage.peak_count << endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 2 && string_equals(argv[1], "bench")) {
+        bool show_stats = false;
+        const char* trace_path = nullptr;
+        const char* snapshot_path = nullptr;
+        for (int i = 3; i < argc; ++i) {
+            if (string_equals(argv[i], "--stats")) {
+                show_stats = true;
+            } else if (string_equals(argv[i], "--trace") && i + 1 < argc) {
+                trace_path = argv[++i];
+            } else if (string_equals(argv[i], "--snapshot") && i + 1 < argc) {
+                snapshot_path = argv[++i];
+            }
+        }
+
+#ifdef SYMPL_TRACE_ALLOCATIONS
+        // Keep the timeline small enough to load in a browser.
+        MemAllocTracer::instance()->set_max_events(200000);
+        SYMPL_TRACE_SCRIPT_POSITION(argv[2], 0, 0);
+#else
+        if (trace_path) {
+            cout << "Allocation tracing is not compiled in, configure with -DSYMPL_TRACE_ALLOCATIONS=ON" << endl;
+            return 1;
+        }
+#endif
+
+        if (string_equals(argv[2], "pool_alloc")) {
+            bench_pool_alloc();
+        } else if (string_equals(argv[2], "pool_threads")) {
+            bench_pool_threads();
+        } else if (string_equals(argv[2], "pool_startup")) {
+            bench_pool_startup();
+        } else if (string_equals(argv[2], "cycles")) {
+            bench_cycles();
+        } else if (string_equals(argv[2], "pool_clears")) {
+            bench_pool_clears();
+        } else if (string_equals(argv[2], "handles")) {
+            bench_handles();
+        } else if (string_equals(argv[2], "type_checks")) {
+            bench_type_checks();
+        } else if (string_equals(argv[2], "trim")) {
+            bench_trim();
+        } else if (string_equals(argv[2], "heap_walk")) {
+            bench_heap_walk();
+        } else if (string_equals(argv[2], "large_objects")) {
+            bench_large_objects();
+        } else if (string_equals(argv[2], "make")) {
+            bench_make();
+        } else if (string_equals(argv[2], "immortals")) {
+            bench_immortals();
+        } else if (string_equals(argv[2], "borrowed_refs")) {
+            bench_borrowed_refs();
+        } else if (string_equals(argv[2], "vm_heaps")) {
+            bench_vm_heaps();
+        } else if (string_equals(argv[2], "scratch")) {
+            bench_scratch();
+        } else if (string_equals(argv[2], "deferred_release")) {
+            bench_deferred_release();
+        } else if (string_equals(argv[2], "strings")) {
+            bench_strings();
+        } else if (string_equals(argv[2], "append")) {
+            bench_append();
+        } else if (string_equals(argv[2], "heap_snapshot")) {
+            bench_heap_snapshot();
+        } else if (string_equals(argv[2], "shared_ptr_moves")) {
+            bench_shared_ptr_moves();
+        } else {
+            cout << "Unknown benchmark: " << argv[2] << endl;
+            return 1;
+        }
+
+        if (show_stats) {
+            print_mem_stats();
+        }
+
+        // Whatever a benchmark left alive is a leak.
+        if (snapshot_path) {
+            MemHeapSnapshot snapshot;
+            snapshot.take(MemPool::instance());
+            if (!snapshot.write(snapshot_path)) {
+                cout << "Could not write snapshot: " << snapshot_path << endl;
+                return 1;
+            }
+        }
+
+#ifdef SYMPL_TRACE_ALLOCATIONS
+        MemAllocTracer::instance()->write_top_sites(10, cout);
+        if (trace_path && !MemAllocTracer::instance()->write_chrome_trace(trace_path)) {
+            cout << "Could not write trace: " << trace_path << endl;
+            return 1;
+        }
+#endif
+        return 0;
+    }
+
+    if (argc > 1 && string_equals(argv[1], "stats")) {
+        print_mem_stats();
+        return 0;
+    }
+
+    if (argc > 3 && string_equals(argv[1], "heap_diff")) {
+        MemHeapSnapshot before;
+        MemHeapSnapshot after;
+        if (!before.read(argv[2]) || !after.read(argv[3])) {
+            cout << "Could not read snapshots: " << argv[2] << ", " << argv[3] << endl;
+            return 1;
+        }
+
+        std::vector<MemHeapTypeDelta> deltas;
+        MemHeapSnapshot::diff(before, after, deltas);
+        MemHeapSnapshot::write_diff(deltas, argc > 4 ? static_cast<size_t>(std::atoi(argv[4])) : 20, cout);
+        return 0;
+    }
+
+    return 0;
+}
@@ -4,6 +4,67 @@
 #include "string_buffer.hpp"
 SymplNamespace
 
+namespace {
+
+// Returns the pool a string's buffers come from: the heap the string lives
+// in, or the current one while it is still being constructed.
+MemPool* get_buffer_pool(const StringBuffer* string)
+{
+    return string->mem_block ? string->mem_block->pool : MemPool::current();
+}
+
+// Allocates a zeroed string buffer, for strings past the inline bytes. Buffers past the large object threshold
+// get a mapping of their own so they don't sit in the process heap.
+uchar* alloc_string_bytes(const StringBuffer* string, size_t capacity)
+{
+    MemPool* pool = get_buffer_pool(string);
+    if (pool->is_large_size(capacity)) {
+        return reinterpret_cast<uchar*>(pool->alloc_large_buffer(capacity));
+    }
+    return alloc_bytes_array(uchar, capacity);
+}
+
+// Frees a buffer from alloc_string_bytes, given the capacity it was allocated with.
+// Capacities that fit the inline bytes never had a buffer allocated.
+void free_string_bytes(const StringBuffer* string, uchar*& buffer, size_t capacity)
+{
+    if (!buffer || capacity <= SYMPL_STRING_BUFFER_INLINE_CAPACITY) {
+        return;
+    }
+
+    MemPool* pool = get_buffer_pool(string);
+    if (pool->is_large_size(capacity)) {
+        pool->free_large_buffer(reinterpret_cast<StrPtr>(buffer));
+        buffer = nullptr;
+    } else {
+        free_bytes_array(buffer);
+    }
+}
+
+// Grows a buffer from alloc_string_bytes, keeping the first length bytes
+// and zeroing the rest. Small buffers go through realloc, which can often
+// extend them where they are.
+uchar* realloc_string_bytes(const StringBuffer* string, uchar* buffer, size_t length, size_t capacity, size_t newCapacity)
+{
+    MemPool* pool = get_buffer_pool(string);
+    if (capacity > SYMPL_STRING_BUFFER_INLINE_CAPACITY && !pool->is_large_size(capacity) && !pool->is_large_size(newCapacity)) {
+        auto newBuffer = static_cast<uchar*>(realloc(buffer, newCapacity));
+        if (newBuffer) {
+            memset(newBuffer + capacity, 0, newCapacity - capacity);
+        }
+        return newBuffer;
+    }
+
+    auto newBuffer = alloc_string_bytes(string, newCapacity);
+    if (newBuffer) {
+        memcpy(newBuffer, buffer, length);
+        free_string_bytes(string, buffer, capacity);
+    }
+    return newBuffer;
+}
+
+}
+
 StringBuffer::StringBuffer(const char *str, size_t capacity)
 {
     init(str, capacity);
@@ -11,7 +72,12 @@ StringBuffer::StringBuffer(const char *str, size_t capacity)
 
 StringBuffer::StringBuffer(const char *str)
 {
-    init(str, SYMPL_STRING_BUFFER_CAPACITY);
+    init(str, SYMPL_STRING_BUFFER_INLINE_CAPACITY);
+}
+
+StringBuffer::StringBuffer(const StringBuffer& p_string) : ManagedObject(p_string)
+{
+    init(reinterpret_cast<const char*>(p_string._buffer), p_string._capacity);
 }
 
 StringBuffer::StringBuffer()
@@ -21,27 +87,40 @@ StringBuffer::StringBuffer()
 
 void StringBuffer::__construct()
 {
-    init("", SYMPL_STRING_BUFFER_CAPACITY);
+    init("", SYMPL_STRING_BUFFER_INLINE_CAPACITY);
 }
 
-void StringBuffer::init(const char *str, size_t capacity)
+void StringBuffer::__destruct()
+{
+    free_string_bytes(this, _buffer, _capacity);
+}
+
+void StringBuffer::__relocate(const ManagedObject& p_source)
 {
-    // Confirm the string capacity.
-    size_t confirmedCapacity = capacity;
-    if (strlen(str) > confirmedCapacity) {
-        confirmedCapacity = strlen(str) + SYMPL_STRING_BUFFER_CAPACITY;
+    if (static_cast<const StringBuffer&>(p_source).is_inline()) {
+        _buffer = _inline_bytes;
     }
+}
 
-    // Our new string memory size to allocate.
-    size_t strCapacity = sizeof(uchar) * confirmedCapacity;
+void StringBuffer::init(const char *str, size_t capacity)
+{
+    // Confirm the string capacity, leaving room for the terminator.
+    size_t strLength = strlen(str);
+    size_t confirmedCapacity = std::max(capacity, strLength + 1);
 
-    // Create/clean up our string.
-    _buffer = alloc_bytes_array(uchar, SYMPL_STRING_BUFFER_CAPACITY);
-    memset(_buffer, 0, strCapacity);
-    memcpy(_buffer, str, strlen(str) + 1);
+    // Create/clean up our string, the new buffer comes back zeroed.
+    free_string_bytes(this, _buffer, _capacity);
+    if (confirmedCapacity <= SYMPL_STRING_BUFFER_INLINE_CAPACITY) {
+        confirmedCapacity = SYMPL_STRING_BUFFER_INLINE_CAPACITY;
+        memset(_inline_bytes, 0, SYMPL_STRING_BUFFER_INLINE_CAPACITY);
+        _buffer = _inline_bytes;
+    } else {
+        _buffer = alloc_string_bytes(this, confirmedCapacity);
+    }
+    memcpy(_buffer, str, strLength + 1);
 
-    _length = strlen(str);
-    _capacity = capacity;
+    _length = strLength;
+    _capacity = confirmedCapacity;
 }
 
 void StringBuffer::prepend(const char *str)
@@ -53,72 +132,64 @@ void StringBuffer::prepend(const char *str)
 
     // Ensure we have enough capacity.
     if ((_length + strSize) >= _capacity) {
-        resize_string(_length + strSize + SYMPL_STRING_BUFFER_CAPACITY);
+        resize_string(_length + strSize + 1);
     }
 
-    auto tmpBuffer = alloc_bytes_array(uchar, _capacity);
-    memcpy(tmpBuffer + strlen(str), _buffer, _length);
-    memcpy(tmpBuffer, str, strlen(str));
-
-    free_bytes_array(_buffer);
-    _buffer = tmpBuffer;
+    // Shift in place, the inline bytes can't be swapped for a new buffer.
+    memmove(_buffer + strSize, _buffer, _length);
+    memcpy(_buffer, str, strSize);
 
-    _length += strlen(str);
+    _length += strSize;
 }
 
 void StringBuffer::prepend_byte(const char byte)
 {
     // Ensure we have enough capacity.
     if ((_length + 1) >= _capacity) {
-        resize_string(_length + 1 + SYMPL_STRING_BUFFER_CAPACITY);
+        resize_string(_length + 2);
     }
 
-    auto tmpBuffer = alloc_bytes_array(uchar, _capacity);
-    memset(tmpBuffer, 0, _capacity);
-    memcpy(tmpBuffer + 1, _buffer, _length);
-    tmpBuffer[0] = static_cast<uchar>(byte);
+    memmove(_buffer + 1, _buffer, _length);
+    _buffer[0] = static_cast<uchar>(byte);
     _length += 1;
-
-    free_bytes_array(_buffer);
-    _buffer = tmpBuffer;
 }
 
 void StringBuffer::append(StringBuffer *str)
 {
-    append(str->cstr());
+    append_bytes(str->cstr(), str->length());
 }
 
-void StringBuffer::append(const std::string str)
+void StringBuffer::append(const std::string& str)
 {
-    append(str.c_str());
+    append_bytes(str.c_str(), str.size());
 }
 
 void StringBuffer::append(const char *str)
 {
-    size_t strSize = strlen(str);
-    if (strSize == 0) {
+    append_bytes(str, strlen(str));
+}
+
+void StringBuffer::append_bytes(const char *bytes, size_t size)
+{
+    if (size == 0) {
         return;
     }
 
     // Ensure we have enough capacity.
-    if ((_length + strSize) >= _capacity) {
-        resize_string(_length + strSize + SYMPL_STRING_BUFFER_CAPACITY);
+    if ((_length + size) >= _capacity) {
+        resize_string(_length + size + 1);
     }
 
-    size_t index = 0;
-    while (index < strSize) {
-        _buffer[_length + index] = static_cast<uchar>(str[index]);
-        index++;
-    }
-
-    _length += strlen(str);
+    // The bytes past the string are zero, so the terminator is already there.
+    memcpy(_buffer + _length, bytes, size);
+    _length += size;
 }
 
 void StringBuffer::append_byte(const char byte)
 {
     // Ensure we have enough capacity.
-    if ((_length + 2) >= _capacity) {
-        resize_string(_length + 2 + SYMPL_STRING_BUFFER_CAPACITY);
+    if ((_length + 1) >= _capacity) {
+        resize_string(_length + 2);
     }
 
     _buffer[_length] = static_cast<uchar>(byte);
@@ -136,28 +207,29 @@ void StringBuffer::resize_string(size_t newCapacity)
     // Check if we need to clear everything.
     if (newCapacity <= _capacity) {
         return;
-    } else {
-        // We probably need a lot of room for this buffer,
-        // so really up the capacity.
-        _capacity = newCapacity + (_capacity * 5);
     }
 
-    auto *tmpStr = reinterpret_cast<uchar*>(calloc(_capacity, sizeof(uchar)));
+    reallocate(std::max(newCapacity, _capacity + _capacity / 2));
+}
 
-    if (_length > 0) {
-        size_t index = 0;
-        while (index < _length) {
-            tmpStr[index] = _buffer[index];
-            index++;
-        }
+void StringBuffer::reserve(size_t length)
+{
+    if (length < _capacity) {
+        return;
     }
 
-    if (_use_dynamic_buffer) {
-        free(_buffer);
+    reallocate(length + 1);
+}
+
+void StringBuffer::reallocate(size_t newCapacity)
+{
+    auto newBuffer = realloc_string_bytes(this, _buffer, _length, _capacity, newCapacity);
+    if (!newBuffer) {
+        return;
     }
 
-    _buffer = tmpStr;
-    _use_dynamic_buffer = true;
+    _buffer = newBuffer;
+    _capacity = newCapacity;
 }
 
 void StringBuffer::replace_string_at(const char* str, size_t startIndex, size_t length)
@@ -165,11 +237,13 @@ void StringBuffer::replace_string_at(const char* str, size_t startIndex, size_t
     size_t len = length == 0 ? strlen(str) : length;
     size_t end = len + startIndex;
     if (end >= _capacity) {
-        resize_string(_capacity);
+        resize_string(end + 1);
     }
 
     if (len == 0) {
-        memset(_buffer + startIndex, 0, _length);
+        if (startIndex < _length) {
+            memset(_buffer + startIndex, 0, _length - startIndex);
+        }
     } else {
         memcpy(_buffer + startIndex, str, len);
     }
@@ -491,21 +565,24 @@ void StringBuffer::clear()
 {
     if (_length == 0) return;
 
+    // Only the string needs zeroing, the bytes past it are zero already.
+    memset(_buffer, 0, _length);
     _length = 0;
-    memset(_buffer, 0, _capacity);
 }
 
 void StringBuffer::clear_at(size_t startIndex)
 {
     if (_length == 0) return;
 
+    if (startIndex < _length) {
+        memset(_buffer + startIndex, 0, _length - startIndex);
+    }
     _length = startIndex;
-    memset(_buffer + startIndex, 0, _length);
 }
 
 bool StringBuffer::destroy()
 {
-    free_bytes_array(_buffer);
+    free_string_bytes(this, _buffer, _capacity);
     return true;
 }
 
@@ -8,28 +8,41 @@ SymplNamespaceStart
 
 typedef unsigned char uchar;
 #define SYMPL_STRING_BUFFER_CAPACITY 256
+// Bytes kept inside the object for short strings, terminator included.
+#define SYMPL_STRING_BUFFER_INLINE_CAPACITY 24
 
 class SYMPL_API StringBuffer : public ManagedObject
 {
 	SYMPL_OBJECT(StringBuffer, ManagedObject)
 
 private:
-    /// Buffer for holding the string.
-    uchar      *_buffer;
-
-    /// Flag to switch to the dynamic buffer.
-    bool        _use_dynamic_buffer = false;
+    /// Buffer for holding the string, _capacity bytes long.
+    /// Points at _inline_bytes until the string outgrows them, so a bitwise
+    /// copy has to go through __relocate.
+    uchar      *_buffer = nullptr;
 
     /// Current length of the string.
     size_t      _length = 0;
     /// Capacity for the string
-    size_t      _capacity = SYMPL_STRING_BUFFER_CAPACITY;
+    size_t      _capacity = SYMPL_STRING_BUFFER_INLINE_CAPACITY;
+
+    /// Storage for short strings, so most strings never allocate a buffer.
+    uchar       _inline_bytes[SYMPL_STRING_BUFFER_INLINE_CAPACITY];
 
     //! Initializes the string buffer.
     //! \param str
     //! \param capacity
     void init(const char *str, size_t capacity);
 
+    //! Moves the string to a buffer of exactly the given capacity.
+    //! \param newCapacity
+    void reallocate(size_t newCapacity);
+
+    //! Appends bytes of a known length.
+    //! \param bytes
+    //! \param size
+    void append_bytes(const char *bytes, size_t size);
+
 public:
     //! Constructor.
     //! \param str
@@ -43,9 +56,20 @@ public:
     //! Constructor.
     StringBuffer();
 
+    //! Copy constructor, the copy gets a buffer of its own.
+    //! \param p_string
+    StringBuffer(const StringBuffer& p_string);
+
     //! Called in place of the constructor.
     void __construct();
 
+    //! Called in place of the destructor.
+    void __destruct() override;
+
+    //! Points a bitwise copy of a short string at its own inline bytes.
+    //! \param p_source
+    void __relocate(const ManagedObject& p_source) override;
+
     //! Prepends a string to the current buffer.
     //! \param str
     void prepend(const char *str);
@@ -60,7 +84,7 @@ public:
 
     //! Appends a string to the current buffer.
     //! \param str
-    void append(const std::string str);
+    void append(const std::string& str);
 
     //! Appends a string to the current buffer.
     //! \param str
@@ -76,10 +100,17 @@ public:
      */
     void set_string(const char* str);
 
-    //! Resizes the string buffer.
+    //! Grows the string buffer to hold at least the given capacity, by
+    //! half again its current capacity at least, so repeated appends copy
+    //! each byte a constant number of times.
     //! \param newCapacity
     void resize_string(size_t newCapacity);
 
+    //! Makes room for a string of the given length, terminator not included,
+    //! so appends up to it never grow the buffer.
+    //! \param length
+    void reserve(size_t length);
+
     //! Copy text from a given point.
     void replace_string_at(const char* str, size_t startIndex, size_t length = 0);
 
@@ -187,6 +218,10 @@ public:
     //! \return size_t
     inline size_t capacity() const { return _capacity; }
 
+    //! Returns whether the string still fits in the bytes inside the object.
+    //! \return
+    inline bool is_inline() const { return _buffer == _inline_bytes; }
+
     //! Returns whether or not a string equals the buffer's string.
     //! \return bool
     inline bool equals(StringBuffer* buffer) { return equals(buffer->cstr()); }
@@ -217,8 +252,8 @@ public:
     //! \param location
     //! \param byte
     inline void set_byte(size_t location, const char byte) {
-        if (location >= _capacity) {
-            resize_string(_capacity + 5);
+        if (location + 1 >= _capacity) {
+            resize_string(location + 2);
         }
         _buffer[location] = byte;
     }
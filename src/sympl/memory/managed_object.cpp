@@ -4,11 +4,18 @@
 #include "managed_object.hpp"
 SymplNamespace
 
+std::atomic<long long> Sympl::_sympl_object_next_instance_id(0);
+
 ManagedObject::ManagedObject()
 {
     mem_block = nullptr;
 }
 
+ManagedObject::ManagedObject(const ManagedObject&) : ObjectRef()
+{
+    mem_block = nullptr;
+}
+
 ManagedObject::~ManagedObject()
 {
 }
@@ -19,26 +26,83 @@ void ManagedObject::__construct(int argc, va_list ArgList)
 
 int ManagedObject::release()
 {
-    if (mem_block && mem_block->is_static) {
+    if (is_immortal()) {
         return 1;
     }
 
+    // The scratch arena destructs temporaries itself when the frame is reset.
+    if (in_scratch) {
+        return static_cast<int>(--ref_count);
+    }
+
+    // The cycle collector frees garbage itself once every reference into it is dropped.
+    if (cycle_color == MemCycleColor::Garbage) {
+        return ObjectRef::release();
+    }
+
     auto Result = ObjectRef::release();
-    assert(Result >= 0);
+    sympl_assert(Result >= 0);
 
-    if (Result == 0 && mem_block && mem_block->block_index > 0)
+    if (Result == 0 && mem_block && mem_block->block_index != static_cast<size_t>(-1))
+    {
+        MemCycleCollector* collector = cycle_buffered ? MemCycleCollector::instance() : nullptr;
+        if (collector) {
+            collector->remove_candidate(this);
+        }
+
+        MemReleaseQueue* queue = MemReleaseQueue::active();
+        if (queue) {
+            // Handles go stale now, so nothing can revive the object before the queue destroys it.
+            mem_block->retire();
+            queue->push(this);
+        } else {
+            free_object();
+        }
+    }
+    else if (Result > 0 && cycle_traceable)
     {
-        __destruct();
-        MemPool::instance()->free_block(mem_block);
-        mem_block = nullptr;
+        // What is left could be references from a cycle, so buffer it as a possible root.
+        MemCycleCollector* collector = MemCycleCollector::instance();
+        if (collector) {
+            collector->add_candidate(this);
+        }
     }
 
     return Result;
 }
 
+void ManagedObject::set_immortal()
+{
+    sympl_assert(!in_scratch);
+
+    // Immortal objects are never traced, so they can't stay buffered as cycle roots.
+    if (cycle_buffered) {
+        MemCycleCollector* collector = MemCycleCollector::instance();
+        if (collector) {
+            collector->remove_candidate(this);
+        }
+    }
+
+    ref_count = SYMPL_OBJECT_IMMORTAL_REF_COUNT;
+    if (mem_block) {
+        mem_block->pool->set_static(mem_block, true);
+    }
+}
+
+void ManagedObject::free_object()
+{
+    __destruct();
+
+    // Large blocks are unmapped as they are freed, so the object is off limits afterwards.
+    MemBlock* block = mem_block;
+    mem_block = nullptr;
+    block->pool->free_block(block);
+}
+
 ManagedObject* ManagedObject::mem_copy()
 {
     auto mem_data = static_cast<ManagedObject*>(malloc(object_size));
     memcpy(static_cast<void*>(mem_data), static_cast<void*>(this), object_size);
+    mem_data->__relocate(*this);
     return mem_data;
 }
\ No newline at end of file
@@ -6,15 +6,77 @@
 #include "mem_pool.hpp"
 #include "shared_ptr.hpp"
 #include "object_ref.hpp"
+#include "mem_cycle_collector.hpp"
+#include "mem_scratch_arena.hpp"
+#include "mem_release_queue.hpp"
 
 SymplNamespaceStart
 
 class SYMPL_API ManagedObject : public ObjectRef
 {
+    friend class MemCycleCollector;
+    friend class MemReleaseQueue;
+
 private:
     // Size of the object.
     size_t object_size = 0;
 
+    // Cycle collector state.
+    MemCycleColor cycle_color = MemCycleColor::Black;
+    bool cycle_buffered = false;
+    bool cycle_traceable = false;
+
+    // Whether the object lives in a scratch arena rather than a pool block.
+    bool in_scratch = false;
+    unsigned int cycle_buffer_index = 0;
+
+    /**
+     * Destructs the object and returns its block to the pool.
+     */
+    void free_object();
+
+    /**
+     * Returns whether a type reports references through __trace.
+     * @tparam T
+     * @return
+     */
+    template<class T>
+    static constexpr bool is_traceable()
+    {
+        return !std::is_same<decltype(&T::__trace), decltype(&ManagedObject::__trace)>::value;
+    }
+
+    /**
+     * Returns whether a type frees memory held outside the pool in __destruct.
+     * @tparam T
+     * @return
+     */
+    template<class T>
+    static constexpr bool has_destruct_hook()
+    {
+        return !std::is_same<decltype(&T::__destruct), decltype(&ManagedObject::__destruct)>::value;
+    }
+
+    /**
+     * Hooks a freshly constructed object up to the pool block it lives in.
+     * @tparam T
+     * @param p_object
+     * @param p_mem_block
+     */
+    template<class T>
+    static void attach_block(T* p_object, MemBlock* p_mem_block)
+    {
+        ManagedObject* object = p_object;
+        object->mem_block = p_mem_block;
+        object->object_size = sizeof(T);
+        object->instance_id = _sympl_object_next_instance_id++;
+        object->cycle_traceable = is_traceable<T>();
+        p_mem_block->set_type_info(T::get_type_info_static());
+        if (has_destruct_hook<T>()) {
+            p_mem_block->pool->set_destruct(p_mem_block);
+        }
+    }
+
 public:
     // The instance id.
     long long instance_id = -1;
@@ -24,6 +86,12 @@ public:
 	 */
 	ManagedObject();
 
+    /**
+     * Copy constructor. The copy starts out unreferenced and outside any block.
+     * @param p_object
+     */
+    ManagedObject(const ManagedObject& p_object);
+
 	/**
 	 * Destructor.
 	 */
@@ -40,17 +108,75 @@ public:
      */
     virtual void __destruct() {}
 
+    /**
+     * Reports every SharedPtr the object holds to other managed objects. Types
+     * that can end up in a reference cycle override this so the cycle
+     * collector can find and free unreachable cycles.
+     * @param p_tracer
+     */
+    virtual void __trace(MemCycleTracer&) {}
+
+    /**
+     * Called on a bitwise copy made by mem_copy. Types holding pointers into
+     * their own bytes override this to point them at the copy.
+     * @param p_source Object the copy was made from.
+     */
+    virtual void __relocate(const ManagedObject&) {}
+
     /**
 	 * Subtract from the reference count.
 	 */
     virtual int release() override;
 
     /**
-     * Performs a memory-based copy.
+     * Pins the reference count and flags the block static, so add_ref and
+     * release return right away and the object is never freed. It outlives
+     * MemPool::free_all_blocks and goes away with MemPool::clear.
+     */
+    void set_immortal();
+
+    /**
+     * Performs a memory-based copy, then lets the copy fix up pointers into itself.
      * @return
      */
     ManagedObject* mem_copy();
 
+    /**
+     * Returns whether the object is a scratch temporary, gone at the end of the frame.
+     * @return
+     */
+    inline bool is_scratch() const { return in_scratch; }
+
+    /**
+     * Returns the pool the object lives in, nullptr if it was not created in one.
+     * @return
+     */
+    inline MemPool* get_pool() const { return mem_block ? mem_block->pool : nullptr; }
+
+    /**
+     * Returns a handle that can be checked for liveness without holding a reference.
+     * @return
+     */
+    inline MemHandle get_handle() const { return mem_block ? mem_block->get_handle() : MemHandle(); }
+
+    /**
+     * Returns the object a handle refers to, or nullptr if it was freed, is not a T,
+     * or lives in another pool than the one given.
+     * @tparam T
+     * @param p_handle
+     * @param p_pool Pool the object was made in, the current one by default.
+     * @return
+     */
+    template<class T>
+    static T* from_handle(MemHandle p_handle, const MemPool* p_pool = MemPool::current())
+    {
+        MemBlock* block = p_pool->resolve(p_handle);
+        if (!block) {
+            return nullptr;
+        }
+        return ObjectRef::cast_to<T>(reinterpret_cast<ManagedObject*>(block->bytes));
+    }
+
 	/**
 	 * Creates a new managed object.
 	 * @tparam T
@@ -59,17 +185,7 @@ public:
 	template<class T>
 	static SharedPtr<T> __new()
 	{
-		size_t object_size = sizeof(T);
-		MemBlock* mem_block = MemPool::instance()->create_block(object_size);
-		assert(mem_block != nullptr);
-
-		ManagedObject* new_object = new(mem_block->bytes) T();
-		new_object->mem_block = mem_block;
-        new_object->object_size = object_size;
-        new_object->instance_id = _sympl_object_next_instance_id++;
-		mem_block->set_identifier(new_object->get_type_name().c_str());
-
-		return SharedPtr<T>(static_cast<T*>(new_object));
+		return make<T>();
 	}
 
     /**
@@ -81,17 +197,104 @@ public:
     template<class T, class R>
     static SharedPtr<R> __new()
     {
-        size_t object_size = sizeof(T);
-        MemBlock* mem_block = MemPool::instance()->create_block(object_size);
-		assert(mem_block != nullptr);
+        MemBlock* mem_block = MemPool::current()->create_block(sizeof(T), T::get_type_info_static());
+		if (!mem_block) {
+			return SharedPtr<R>();
+		}
 
-        ManagedObject* new_object = new(mem_block->bytes) T();
-        new_object->mem_block = mem_block;
-        new_object->object_size = object_size;
-        new_object->instance_id = _sympl_object_next_instance_id++;
-		mem_block->set_identifier(new_object->get_type_name().c_str());
+        T* new_object = new(mem_block->bytes) T();
+        attach_block(new_object, mem_block);
+
+        return SharedPtr<R>(static_cast<R*>(static_cast<ManagedObject*>(new_object)));
+    }
+
+    /**
+     * Creates a new managed object in a pool block, passing the arguments
+     * straight to its constructor.
+     * @tparam T
+     * @tparam Args
+     * @param p_args
+     * @return
+     */
+    template<class T, class... Args>
+    static SharedPtr<T> make(Args&&... p_args)
+    {
+        MemBlock* mem_block = MemPool::current()->create_block(sizeof(T), T::get_type_info_static());
+        if (!mem_block) {
+            return SharedPtr<T>();
+        }
+
+        T* new_object = new(mem_block->bytes) T(std::forward<Args>(p_args)...);
+        attach_block(new_object, mem_block);
+
+        return SharedPtr<T>(new_object);
+    }
 
-        return SharedPtr<R>(static_cast<R*>(new_object));
+    /**
+     * Creates a managed object that is never freed, for singletons, small
+     * integer caches and builtins that would otherwise be allocated per use.
+     * @tparam T
+     * @tparam Args
+     * @param p_args
+     * @return
+     */
+    template<class T, class... Args>
+    static SharedPtr<T> make_immortal(Args&&... p_args)
+    {
+        SharedPtr<T> object = make<T>(std::forward<Args>(p_args)...);
+        if (object.ptr()) {
+            object->set_immortal();
+        }
+        return object;
+    }
+
+    /**
+     * Creates a temporary in the current scratch arena, or in the current pool
+     * when there is none. Allocating it is a pointer bump, and its references
+     * never free it; the arena destructs it when the frame is reset.
+     * @tparam T
+     * @tparam Args
+     * @param p_args
+     * @return
+     */
+    template<class T, class... Args>
+    static SharedPtr<T> make_scratch(Args&&... p_args)
+    {
+        MemScratchArena* arena = MemScratchArena::current();
+        if (!arena) {
+            return make<T>(std::forward<Args>(p_args)...);
+        }
+
+        void* bytes = arena->allocate(sizeof(T), alignof(T));
+        if (!bytes) {
+            return SharedPtr<T>();
+        }
+
+        T* new_object = new(bytes) T(std::forward<Args>(p_args)...);
+        ManagedObject* object = new_object;
+        object->object_size = sizeof(T);
+        object->instance_id = _sympl_object_next_instance_id++;
+        object->in_scratch = true;
+        arena->add_object(object);
+
+        return SharedPtr<T>(new_object);
+    }
+
+    /**
+     * Returns an object that can outlive the frame: a copy in the current pool
+     * for a scratch temporary, the object itself otherwise. Only the object is
+     * copied, references it holds to other temporaries must be promoted too.
+     * @tparam T Copy constructible managed type.
+     * @param p_object
+     * @return
+     */
+    template<class T>
+    static SharedPtr<T> promote(const SharedPtr<T>& p_object)
+    {
+        if (!p_object.ptr() || !p_object->is_scratch()) {
+            return p_object;
+        }
+        return make<T>(*p_object.ptr());
     }
 
     /**
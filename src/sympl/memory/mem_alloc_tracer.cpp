@@ -0,0 +1,274 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#include "mem_alloc_tracer.hpp"
+
+#ifdef SYMPL_TRACE_ALLOCATIONS
+#include "mem_block.hpp"
+#include "object_ref_info.hpp"
+
+#if defined(__GNUC__) && !defined(_WIN32)
+#include <cxxabi.h>
+#include <dlfcn.h>
+#endif
+SymplNamespace
+
+namespace {
+    // Script position allocations on this thread are attributed to.
+    thread_local const char* thread_script_file = nullptr;
+    thread_local int thread_script_line = 0;
+    thread_local int thread_script_column = 0;
+
+    // Small id of this thread for the timeline, 0 until first used.
+    thread_local unsigned int thread_trace_id = 0;
+    std::atomic<unsigned int> next_thread_trace_id(1);
+
+    unsigned int get_thread_trace_id()
+    {
+        if (thread_trace_id == 0) {
+            thread_trace_id = next_thread_trace_id++;
+        }
+        return thread_trace_id;
+    }
+
+    // Writes a string as a JSON string literal.
+    void write_json_string(std::ostream& p_output, const std::string& p_value)
+    {
+        p_output << '"';
+        for (char c : p_value) {
+            if (c == '"' || c == '\\') {
+                p_output << '\\' << c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                p_output << ' ';
+            } else {
+                p_output << c;
+            }
+        }
+        p_output << '"';
+    }
+}
+
+MemAllocTracer::MemAllocTracer()
+{
+    start_time = std::chrono::steady_clock::now();
+}
+
+MemAllocTracer* MemAllocTracer::instance()
+{
+    // Never destroyed, so pools torn down at exit can still report frees.
+    static MemAllocTracer* tracer = new MemAllocTracer();
+    return tracer;
+}
+
+void MemAllocTracer::set_script_position(const char* p_file, int p_line, int p_column)
+{
+    thread_script_file = p_file;
+    thread_script_line = p_line;
+    thread_script_column = p_column;
+}
+
+unsigned int MemAllocTracer::find_site(const void* p_address, const ObjectRefInfo* p_type_info)
+{
+    MemAllocSiteKey key = { p_address, p_type_info, thread_script_file, thread_script_line, thread_script_column };
+    auto entry = site_lookup.find(key);
+    if (entry != site_lookup.end()) {
+        return entry->second;
+    }
+
+    MemAllocSite site;
+    site.address = p_address;
+    site.type_info = p_type_info;
+    site.script_file = thread_script_file;
+    site.script_line = thread_script_line;
+    site.script_column = thread_script_column;
+
+    auto index = static_cast<unsigned int>(sites.size());
+    sites.emplace_back(site);
+    site_lookup[key] = index;
+    return index;
+}
+
+void MemAllocTracer::add_event(unsigned int p_site_index, size_t p_size, bool p_is_free)
+{
+    if (events.size() >= max_events) {
+        return;
+    }
+
+    MemAllocEvent event;
+    event.timestamp_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count();
+    event.site_index = p_site_index;
+    event.thread_id = get_thread_trace_id();
+    event.size = p_size;
+    event.is_free = p_is_free;
+    events.emplace_back(event);
+}
+
+void MemAllocTracer::record_alloc(MemBlock* p_block, const ObjectRefInfo* p_type_info, const void* p_address)
+{
+    if (!p_block || !enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    unsigned int site_index = find_site(p_address, p_type_info);
+    MemAllocSite& site = sites[site_index];
+    site.alloc_count++;
+    site.alloc_bytes += p_block->block_size;
+    site.live_bytes += static_cast<long long>(p_block->block_size);
+    site.peak_live_bytes = std::max(site.peak_live_bytes, site.live_bytes);
+
+    // Index 0 means the block was handed out while tracing was off.
+    p_block->trace_site = site_index + 1;
+    add_event(site_index, p_block->block_size, false);
+}
+
+void MemAllocTracer::record_free(const MemBlock* p_block)
+{
+    if (!p_block || p_block->trace_site == 0 || !enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    unsigned int site_index = p_block->trace_site - 1;
+    if (site_index >= sites.size()) {
+        return;
+    }
+
+    MemAllocSite& site = sites[site_index];
+    site.free_count++;
+    site.live_bytes -= static_cast<long long>(p_block->block_size);
+    add_event(site_index, p_block->block_size, true);
+}
+
+void MemAllocTracer::set_max_events(size_t p_max_events)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    max_events = p_max_events;
+}
+
+void MemAllocTracer::reset()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    sites.clear();
+    site_lookup.clear();
+    events.clear();
+    start_time = std::chrono::steady_clock::now();
+}
+
+void MemAllocTracer::get_top_sites(size_t p_count, std::vector<MemAllocSite>& p_output) const
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        p_output = sites;
+    }
+
+    std::sort(p_output.begin(), p_output.end(), [](const MemAllocSite& p_a, const MemAllocSite& p_b) {
+        return p_a.alloc_bytes > p_b.alloc_bytes;
+    });
+    if (p_output.size() > p_count) {
+        p_output.resize(p_count);
+    }
+}
+
+void MemAllocTracer::get_sites(std::vector<MemAllocSite>& p_output) const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    p_output = sites;
+}
+
+std::string MemAllocTracer::get_site_name(const MemAllocSite& p_site)
+{
+    std::stringstream name;
+
+#if defined(__GNUC__) && !defined(_WIN32)
+    Dl_info info;
+    if (dladdr(p_site.address, &info) && info.dli_sname) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        name << (status == 0 && demangled ? demangled : info.dli_sname);
+        name << "+0x" << std::hex << (reinterpret_cast<size_t>(p_site.address) - reinterpret_cast<size_t>(info.dli_saddr));
+        free(demangled);
+        return name.str();
+    }
+    if (dladdr(p_site.address, &info) && info.dli_fname) {
+        name << info.dli_fname << "+0x" << std::hex << (reinterpret_cast<size_t>(p_site.address) - reinterpret_cast<size_t>(info.dli_fbase));
+        return name.str();
+    }
+#endif
+
+    name << p_site.address;
+    return name.str();
+}
+
+void MemAllocTracer::write_top_sites(size_t p_count, std::ostream& p_output) const
+{
+    std::vector<MemAllocSite> top_sites;
+    get_top_sites(p_count, top_sites);
+
+    p_output << "alloc_bytes,alloc_count,free_count,live_bytes,peak_live_bytes,type,script,site" << std::endl;
+    for (const auto& site : top_sites) {
+        p_output << site.alloc_bytes << "," << site.alloc_count << "," << site.free_count << ","
+                 << site.live_bytes << "," << site.peak_live_bytes << ","
+                 << (site.type_info ? site.type_info->get_type_name() : "-") << ",";
+        if (site.script_file) {
+            p_output << site.script_file << ":" << site.script_line << ":" << site.script_column;
+        } else {
+            p_output << "-";
+        }
+        p_output << "," << get_site_name(site) << std::endl;
+    }
+}
+
+bool MemAllocTracer::write_chrome_trace(const char* p_path) const
+{
+    std::ofstream output(p_path);
+    if (!output) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    // Site names are looked up once, symbolizing per event would dominate the export.
+    std::vector<std::string> site_names;
+    site_names.reserve(sites.size());
+    for (const auto& site : sites) {
+        site_names.emplace_back(get_site_name(site));
+    }
+
+    output << "{\"traceEvents\":[";
+
+    long long live_bytes = 0;
+    bool first = true;
+    for (const auto& event : events) {
+        const MemAllocSite& site = sites[event.site_index];
+        live_bytes += event.is_free ? -static_cast<long long>(event.size) : static_cast<long long>(event.size);
+
+        // Instant event for the allocation itself.
+        output << (first ? "\n" : ",\n") << "{\"name\":";
+        write_json_string(output, site.type_info ? site.type_info->get_type_name() : std::string("block"));
+        output << ",\"cat\":\"" << (event.is_free ? "free" : "alloc") << "\",\"ph\":\"i\",\"s\":\"t\""
+               << ",\"ts\":" << event.timestamp_us << ",\"pid\":1,\"tid\":" << event.thread_id
+               << ",\"args\":{\"size\":" << event.size << ",\"site\":";
+        write_json_string(output, site_names[event.site_index]);
+        if (site.script_file) {
+            output << ",\"script\":";
+            std::stringstream position;
+            position << site.script_file << ":" << site.script_line << ":" << site.script_column;
+            write_json_string(output, position.str());
+        }
+        output << "}}";
+
+        // Counter track of the bytes live in traced blocks.
+        output << ",\n{\"name\":\"live_bytes\",\"ph\":\"C\",\"ts\":" << event.timestamp_us
+               << ",\"pid\":1,\"args\":{\"bytes\":" << live_bytes << "}}";
+        first = false;
+    }
+
+    output << "\n]}\n";
+    return static_cast<bool>(output);
+}
+
+#endif
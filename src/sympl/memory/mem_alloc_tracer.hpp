@@ -0,0 +1,245 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include <sympl/sympl_pch.hpp>
+
+// Allocation tracing is compiled in with -DSYMPL_TRACE_ALLOCATIONS=ON. When
+// it is off the hooks below expand to nothing.
+#ifdef SYMPL_TRACE_ALLOCATIONS
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SYMPL_RETURN_ADDRESS() _ReturnAddress()
+#else
+#define SYMPL_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+
+// Records a block handed out by a pool, attributed to the caller of the hooking function.
+#define SYMPL_TRACE_ALLOC(block, type_info) Sympl::MemAllocTracer::instance()->record_alloc(block, type_info, SYMPL_RETURN_ADDRESS())
+// Records a block given back to a pool.
+#define SYMPL_TRACE_FREE(block) Sympl::MemAllocTracer::instance()->record_free(block)
+// Sets the script position allocations on this thread are attributed to.
+#define SYMPL_TRACE_SCRIPT_POSITION(file, line, column) Sympl::MemAllocTracer::set_script_position(file, line, column)
+
+SymplNamespaceStart
+
+class MemBlock;
+class ObjectRefInfo;
+
+// Most timeline events kept for the Chrome trace export.
+#define SYMPL_MEM_ALLOC_TRACER_MAX_EVENTS 1000000
+
+/**
+ * Allocations made from one C++ call site, for one type, at one script position.
+ */
+struct SYMPL_API MemAllocSite
+{
+    // Return address of the allocation call.
+    const void* address = nullptr;
+
+    // Type allocated, null for untyped blocks.
+    const ObjectRefInfo* type_info = nullptr;
+
+    // Script position, null file when none was set.
+    const char* script_file = nullptr;
+    int script_line = 0;
+    int script_column = 0;
+
+    // Totals.
+    size_t alloc_count = 0;
+    size_t alloc_bytes = 0;
+    size_t free_count = 0;
+    long long live_bytes = 0;
+    long long peak_live_bytes = 0;
+};
+
+/**
+ * What tells one site apart from another.
+ */
+struct SYMPL_API MemAllocSiteKey
+{
+    const void* address;
+    const ObjectRefInfo* type_info;
+    const char* script_file;
+    int script_line;
+    int script_column;
+
+    inline bool operator==(const MemAllocSiteKey& p_other) const
+    {
+        return address == p_other.address && type_info == p_other.type_info && script_file == p_other.script_file &&
+               script_line == p_other.script_line && script_column == p_other.script_column;
+    }
+};
+
+struct SYMPL_API MemAllocSiteKeyHash
+{
+    inline size_t operator()(const MemAllocSiteKey& p_key) const
+    {
+        size_t hash = std::hash<const void*>()(p_key.address);
+        hash = hash * 31 + std::hash<const void*>()(p_key.type_info);
+        hash = hash * 31 + std::hash<const void*>()(p_key.script_file);
+        hash = hash * 31 + static_cast<size_t>(p_key.script_line) * 1024 + static_cast<size_t>(p_key.script_column);
+        return hash;
+    }
+};
+
+/**
+ * A single allocation or free on the timeline.
+ */
+struct SYMPL_API MemAllocEvent
+{
+    // Microseconds since tracing started.
+    double timestamp_us = 0.0;
+
+    // Site the block was allocated from.
+    unsigned int site_index = 0;
+
+    // Small id of the thread.
+    unsigned int thread_id = 0;
+
+    // Block size.
+    size_t size = 0;
+
+    // Whether the event is a free.
+    bool is_free = false;
+};
+
+/**
+ * Process wide allocation tracer. Every hook takes a lock, so it is meant for
+ * finding out what allocates, not for shipping builds.
+ */
+class SYMPL_API MemAllocTracer
+{
+private:
+    // Guards everything below.
+    mutable std::mutex lock;
+
+    // Sites in the order they were first seen.
+    std::vector<MemAllocSite> sites;
+
+    // Index of each site by its key.
+    std::unordered_map<MemAllocSiteKey, unsigned int, MemAllocSiteKeyHash> site_lookup;
+
+    // Timeline, capped at max_events.
+    std::vector<MemAllocEvent> events;
+    size_t max_events = SYMPL_MEM_ALLOC_TRACER_MAX_EVENTS;
+
+    // When tracing started.
+    std::chrono::steady_clock::time_point start_time;
+
+    // Whether hooks record anything.
+    std::atomic<bool> enabled{true};
+
+    /**
+     * Returns the index of the site for a call, adding it if it is new.
+     * @param p_address
+     * @param p_type_info
+     * @return
+     */
+    unsigned int find_site(const void* p_address, const ObjectRefInfo* p_type_info);
+
+    /**
+     * Adds a timeline event if there is room.
+     * @param p_site_index
+     * @param p_size
+     * @param p_is_free
+     */
+    void add_event(unsigned int p_site_index, size_t p_size, bool p_is_free);
+
+public:
+    /**
+     * Constructor.
+     */
+    MemAllocTracer();
+
+    /**
+     * Returns the process wide tracer.
+     * @return
+     */
+    static MemAllocTracer* instance();
+
+    /**
+     * Sets the script position allocations on the calling thread are attributed to.
+     * The file name must outlive the tracer.
+     * @param p_file
+     * @param p_line
+     * @param p_column
+     */
+    static void set_script_position(const char* p_file, int p_line, int p_column);
+
+    /**
+     * Records a block handed out by a pool.
+     * @param p_block
+     * @param p_type_info
+     * @param p_address
+     */
+    void record_alloc(MemBlock* p_block, const ObjectRefInfo* p_type_info, const void* p_address);
+
+    /**
+     * Records a block given back to a pool.
+     * @param p_block
+     */
+    void record_free(const MemBlock* p_block);
+
+    /**
+     * Turns recording on or off.
+     * @param p_enabled
+     */
+    inline void set_enabled(bool p_enabled) { enabled.store(p_enabled, std::memory_order_relaxed); }
+
+    /**
+     * Sets how many timeline events are kept.
+     * @param p_max_events
+     */
+    void set_max_events(size_t p_max_events);
+
+    /**
+     * Drops every site and event recorded so far.
+     */
+    void reset();
+
+    /**
+     * Returns the sites that allocated the most bytes, largest first.
+     * @param p_count
+     * @param p_output
+     */
+    void get_top_sites(size_t p_count, std::vector<MemAllocSite>& p_output) const;
+
+    /**
+     * Returns every site, indexed by a block's trace_site minus one.
+     * @param p_output
+     */
+    void get_sites(std::vector<MemAllocSite>& p_output) const;
+
+    /**
+     * Returns a readable name for a site's call address.
+     * @param p_site
+     * @return
+     */
+    static std::string get_site_name(const MemAllocSite& p_site);
+
+    /**
+     * Writes the top sites as a table.
+     * @param p_count
+     * @param p_output
+     */
+    void write_top_sites(size_t p_count, std::ostream& p_output) const;
+
+    /**
+     * Writes the timeline in Chrome trace_event JSON, for chrome://tracing or Perfetto.
+     * @param p_path
+     * @return false if the file could not be written.
+     */
+    bool write_chrome_trace(const char* p_path) const;
+};
+
+SymplNamespaceEnd
+
+#else
+
+#define SYMPL_TRACE_ALLOC(block, type_info) ((void)0)
+#define SYMPL_TRACE_FREE(block) ((void)0)
+#define SYMPL_TRACE_SCRIPT_POSITION(file, line, column) ((void)0)
+
+#endif
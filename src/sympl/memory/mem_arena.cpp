@@ -0,0 +1,175 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#include "mem_arena.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+SymplNamespace
+
+// Rounds a value up to a power-of-two alignment.
+#define sympl_align_up(value, alignment) (((value) + ((alignment) - 1)) & ~(static_cast<size_t>(alignment) - 1))
+
+MemArena::~MemArena()
+{
+    release();
+}
+
+void* MemArena::allocate(size_t p_size, size_t p_alignment)
+{
+    // Oversized requests get a chunk of their own so the current chunk keeps carving.
+    if (p_size >= chunk_size) {
+        MemArenaChunk* chunk = map_chunk(p_size);
+        if (!chunk) {
+            return nullptr;
+        }
+
+        chunk->used = p_size;
+        StrPtr memory = chunk->base;
+        if (chunks.size() > 1) {
+            std::swap(chunks[chunks.size() - 1], chunks[chunks.size() - 2]);
+        }
+        return memory;
+    }
+
+    if (!chunks.empty()) {
+        MemArenaChunk& chunk = chunks.back();
+        size_t offset = sympl_align_up(chunk.used, p_alignment);
+        if (offset + p_size <= chunk.size) {
+            chunk.used = offset + p_size;
+            return chunk.base + offset;
+        }
+    }
+
+    MemArenaChunk* chunk = map_chunk(p_size);
+    if (!chunk) {
+        return nullptr;
+    }
+
+    chunk->used = p_size;
+    return chunk->base;
+}
+
+bool MemArena::reserve(size_t p_size)
+{
+    if (!chunks.empty() || p_size == 0) {
+        return true;
+    }
+
+    // Map the reservation without growing the chunk size.
+    size_t next_chunk_size = chunk_size;
+    bool mapped = map_chunk(p_size) != nullptr;
+    chunk_size = next_chunk_size;
+    return mapped;
+}
+
+void MemArena::release()
+{
+    for (auto& chunk : chunks) {
+        unmap_memory(chunk.base, chunk.size);
+    }
+
+    chunks.clear();
+    reserved_bytes = 0;
+}
+
+MemArenaChunk* MemArena::map_chunk(size_t p_min_size)
+{
+    size_t size = std::max(chunk_size, sympl_align_up(p_min_size, SYMPL_MEM_ARENA_PAGE_SIZE));
+    if (use_huge_pages) {
+        size = sympl_align_up(size, SYMPL_MEM_ARENA_HUGE_PAGE_SIZE);
+    }
+
+    if (max_reserved_bytes > 0 && reserved_bytes + size > max_reserved_bytes) {
+        return nullptr;
+    }
+
+    StrPtr base = map_memory(size, use_huge_pages);
+    if (!base) {
+        return nullptr;
+    }
+
+    // Grow the next chunk so large heaps need fewer mappings.
+    if (size == chunk_size && growth_factor > 1.0) {
+        auto next_chunk_size = static_cast<size_t>(static_cast<double>(chunk_size) * growth_factor);
+        chunk_size = sympl_align_up(std::min(next_chunk_size, max_chunk_size), SYMPL_MEM_ARENA_PAGE_SIZE);
+    }
+
+    MemArenaChunk chunk;
+    chunk.base = base;
+    chunk.size = size;
+    chunks.emplace_back(chunk);
+    reserved_bytes += size;
+
+    return &chunks.back();
+}
+
+StrPtr MemArena::map_memory(size_t p_size, bool p_use_huge_pages)
+{
+#ifdef _WIN32
+    return static_cast<StrPtr>(VirtualAlloc(nullptr, p_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+    if (!p_use_huge_pages) {
+        void* memory = mmap(nullptr, p_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return memory == MAP_FAILED ? nullptr : static_cast<StrPtr>(memory);
+    }
+
+    // Over-map so the chunk can start on a huge page boundary, then trim the slack.
+    size_t map_size = p_size + SYMPL_MEM_ARENA_HUGE_PAGE_SIZE;
+    void* memory = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+
+    auto start = reinterpret_cast<size_t>(memory);
+    size_t aligned = sympl_align_up(start, SYMPL_MEM_ARENA_HUGE_PAGE_SIZE);
+    size_t head = aligned - start;
+    size_t tail = map_size - head - p_size;
+
+    if (head > 0) {
+        munmap(memory, head);
+    }
+    if (tail > 0) {
+        munmap(reinterpret_cast<void*>(aligned + p_size), tail);
+    }
+
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<void*>(aligned), p_size, MADV_HUGEPAGE);
+#endif
+
+    return reinterpret_cast<StrPtr>(aligned);
+#endif
+}
+
+size_t MemArena::purge_memory(StrPtr p_memory, size_t p_size)
+{
+    auto start = reinterpret_cast<size_t>(p_memory);
+    size_t first = sympl_align_up(start, SYMPL_MEM_ARENA_PAGE_SIZE);
+    size_t last = (start + p_size) & ~(static_cast<size_t>(SYMPL_MEM_ARENA_PAGE_SIZE) - 1);
+    if (last <= first) {
+        return 0;
+    }
+
+#ifdef _WIN32
+    VirtualAlloc(reinterpret_cast<void*>(first), last - first, MEM_RESET, PAGE_READWRITE);
+#else
+    madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+#endif
+    return last - first;
+}
+
+void MemArena::unmap_memory(StrPtr p_memory, size_t p_size)
+{
+    if (!p_memory) {
+        return;
+    }
+
+#ifdef _WIN32
+    VirtualFree(p_memory, 0, MEM_RELEASE);
+#else
+    munmap(p_memory, p_size);
+#endif
+}
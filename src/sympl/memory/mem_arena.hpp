@@ -0,0 +1,178 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include <sympl/sympl_pch.hpp>
+
+SymplNamespaceStart
+
+// Granularity of OS mappings.
+#define SYMPL_MEM_ARENA_PAGE_SIZE 4096
+// Default size of a chunk mapped from the OS.
+#define SYMPL_MEM_ARENA_CHUNK_SIZE (2 * 1024 * 1024)
+// Alignment required for a transparent huge page.
+#define SYMPL_MEM_ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/**
+ * Region of memory mapped from the OS in one call.
+ */
+struct SYMPL_API MemArenaChunk
+{
+    // Start of the mapping.
+    StrPtr base = nullptr;
+
+    // Size of the mapping.
+    size_t size = 0;
+
+    // Bytes handed out so far.
+    size_t used = 0;
+};
+
+/**
+ * Bump allocator over large chunks mapped straight from the OS.
+ * Memory is only given back when the whole arena is released.
+ */
+class SYMPL_API MemArena
+{
+private:
+    // Chunks mapped so far, the last one is carved from.
+    std::vector<MemArenaChunk> chunks;
+
+    // Size of newly mapped chunks.
+    size_t chunk_size = SYMPL_MEM_ARENA_CHUNK_SIZE;
+
+    // Multiplier applied to the chunk size after each chunk is mapped.
+    double growth_factor = 1.0;
+
+    // Largest size the chunk size can grow to.
+    size_t max_chunk_size = SYMPL_MEM_ARENA_CHUNK_SIZE;
+
+    // Most bytes the arena may map, 0 for no limit.
+    size_t max_reserved_bytes = 0;
+
+    // Whether new chunks are aligned and advised to use huge pages.
+    bool use_huge_pages = false;
+
+    // Total bytes mapped.
+    size_t reserved_bytes = 0;
+
+    /**
+     * Maps a new chunk that can hold at least the given size.
+     * @param p_min_size
+     * @return
+     */
+    MemArenaChunk* map_chunk(size_t p_min_size);
+
+public:
+    /**
+     * Constructor.
+     */
+    MemArena() = default;
+
+    /**
+     * Destructor.
+     */
+    ~MemArena();
+
+    MemArena(const MemArena&) = delete;
+    MemArena& operator=(const MemArena&) = delete;
+
+    /**
+     * Carves memory out of the arena.
+     * @param p_size
+     * @param p_alignment
+     * @return
+     */
+    void* allocate(size_t p_size, size_t p_alignment = 16);
+
+    /**
+     * Maps a first chunk of at least the given size if nothing is mapped yet.
+     * @param p_size
+     * @return
+     */
+    bool reserve(size_t p_size);
+
+    /**
+     * Unmaps every chunk. Everything carved from the arena becomes invalid.
+     */
+    void release();
+
+    /**
+     * Sets how chunk sizes grow as the arena maps more memory.
+     * @param p_growth_factor
+     * @param p_max_chunk_size
+     */
+    inline void set_growth(double p_growth_factor, size_t p_max_chunk_size)
+    {
+        growth_factor = p_growth_factor < 1.0 ? 1.0 : p_growth_factor;
+        max_chunk_size = std::max(p_max_chunk_size, chunk_size);
+    }
+
+    /**
+     * Sets the most bytes the arena may map, 0 for no limit.
+     * @param p_max_reserved_bytes
+     */
+    inline void set_max_reserved_bytes(size_t p_max_reserved_bytes) { max_reserved_bytes = p_max_reserved_bytes; }
+
+    /**
+     * Sets the size of chunks mapped from now on.
+     * @param p_chunk_size
+     */
+    inline void set_chunk_size(size_t p_chunk_size) { chunk_size = p_chunk_size; }
+
+    /**
+     * Returns the size of newly mapped chunks.
+     * @return
+     */
+    inline size_t get_chunk_size() const { return chunk_size; }
+
+    /**
+     * Sets whether chunks mapped from now on use huge pages.
+     * @param p_use_huge_pages
+     */
+    inline void set_use_huge_pages(bool p_use_huge_pages) { use_huge_pages = p_use_huge_pages; }
+
+    /**
+     * Returns whether chunks use huge pages.
+     * @return
+     */
+    inline bool get_use_huge_pages() const { return use_huge_pages; }
+
+    /**
+     * Returns the total bytes mapped from the OS.
+     * @return
+     */
+    inline size_t get_reserved_bytes() const { return reserved_bytes; }
+
+    /**
+     * Returns the number of chunks mapped.
+     * @return
+     */
+    inline size_t get_num_chunks() const { return chunks.size(); }
+
+    /**
+     * Maps memory straight from the OS.
+     * @param p_size
+     * @param p_use_huge_pages
+     * @return
+     */
+    static StrPtr map_memory(size_t p_size, bool p_use_huge_pages);
+
+    /**
+     * Returns memory mapped with map_memory to the OS.
+     * @param p_memory
+     * @param p_size
+     */
+    static void unmap_memory(StrPtr p_memory, size_t p_size);
+
+    /**
+     * Gives the OS pages inside a range back while keeping the range mapped.
+     * The pages read back as zero the next time they are touched.
+     * @param p_memory
+     * @param p_size
+     * @return Bytes given back, only whole pages inside the range count.
+     */
+    static size_t purge_memory(StrPtr p_memory, size_t p_size);
+};
+
+SymplNamespaceEnd
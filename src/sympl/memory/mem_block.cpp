@@ -4,12 +4,12 @@
 // All rights reserved.
 //
 #include "mem_block.hpp"
+#include "mem_pool.hpp"
 SymplNamespace
 
 MemBlock::MemBlock() {
     bytes = nullptr;
     block_index = -1; // Consider using size_t and setting to some max value if -1 is used as uninitialized flag
-    active = false;
     is_static = false; // Renamed from 'Static' to avoid keyword confusion
 }
 
@@ -18,24 +18,42 @@ void MemBlock::create(size_t size) {
     free_memory(); // Changed to use the free_memory method for consistency
 
     bytes = static_cast<StrPtr>(calloc(1, size));
+    owns_bytes = true;
     if (!bytes) {
         // Handle allocation failure; might set 'active' to false or throw an exception
     }
 
     block_size = size;
-    active = true;
     is_static = false; // Ensuring the block is marked as non-static upon creation
 
     clear(); // Resets the block's contents
 }
 
+void MemBlock::assign(StrPtr p_bytes, size_t size) {
+    free_memory();
+
+    bytes = p_bytes;
+    owns_bytes = false;
+    block_size = size;
+    is_static = false;
+    type_info = nullptr;
+}
+
 void MemBlock::clear() {
     if (!bytes) {
         return;
     }
 
     memset(bytes, 0, block_size);
-    memset(identifier, 0, sizeof(identifier)); // Clear identifier upon clearing the block
+    type_info = nullptr;
+}
+
+void MemBlock::fill(int p_byte) {
+    if (!bytes) {
+        return;
+    }
+
+    memset(bytes, p_byte, block_size);
 }
 
 void MemBlock::free_memory() { // Renamed from 'Free' to 'free_memory' for consistency
@@ -43,16 +61,15 @@ void MemBlock::free_memory() { // Renamed from 'Free' to 'free_memory' for consi
         return;
     }
 
-    free(bytes);
+    if (owns_bytes) {
+        free(bytes);
+    }
     bytes = nullptr;
     block_size = 0;
     block_index = static_cast<size_t>(-1); // Reset to max size_t value or another designated 'uninitialized' value
-    active = false;
     is_static = false;
 }
 
-void MemBlock::set_identifier(CStrPtr p_identifier) {
-    memset(identifier, 0, sizeof(identifier));
-    // Ensure we don't exceed the identifier buffer size
-    strncpy(identifier, p_identifier, sizeof(identifier) - 1);
+MemHandle MemBlock::get_handle() const {
+    return MemHandle(block_index, generation.load(std::memory_order_relaxed), pool ? pool->get_heap_id() : 0);
 }
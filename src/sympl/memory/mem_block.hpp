@@ -5,51 +5,122 @@
 //
 #pragma once
 #include <sympl/sympl_pch.hpp>
+#include <sympl/memory/object_ref_info.hpp>
+#include <sympl/memory/mem_handle.hpp>
 
 SymplNamespaceStart
 
+class MemPool;
+
+// Byte pattern written over blocks handed out in poison mode.
+#define SYMPL_MEM_BLOCK_ALLOC_POISON 0xCD
+// Byte pattern written over blocks returned in poison mode.
+#define SYMPL_MEM_BLOCK_FREE_POISON 0xDD
+
+/**
+ * How the pool fills block memory on allocation and free.
+ */
+enum class MemFillMode
+{
+    // Hand blocks out as-is; objects are placement-new constructed anyway.
+    None = 0,
+    // Zero blocks on allocation.
+    Zero,
+    // Fill blocks with a poison pattern on allocation and free.
+    Poison
+};
+
 class SYMPL_API MemBlock
 {
 protected:
-    // Identifier used for debugging.
-    char identifier[256];
+    // Type of the object in the block, used for debugging.
+    const ObjectRefInfo* type_info = nullptr;
 
 public:
     // Memory block index.
     size_t block_index = 0;
 
+    // Pool the block was carved from, so the object goes back to its own heap.
+    MemPool* pool = nullptr;
+
     // Current size of the block.
     size_t block_size;
 
-    // Max size of the block.
-    bool active;
-
-    // Check if this block can be changed.
+    // Check if this block can be changed. Mirrors the static bit in the pool's block
+    // table, kept here too since add_ref and release check it on every call.
     bool is_static;
 
     // Memory of the block.
     StrPtr bytes;
 
+    // Next block in the pool's size class free list.
+    MemBlock* next_free = nullptr;
+
+    // Whether the block allocated its own bytes, or was carved from a pool page.
+    bool owns_bytes = true;
+
+    // Pool page the block bytes were carved from, or the slot of a large block in the large object space.
+    unsigned int page_index = 0;
+
+#ifdef SYMPL_TRACE_ALLOCATIONS
+    // Allocation site the block was last handed out from, 0 for none.
+    unsigned int trace_site = 0;
+#endif
+
+    // Bumped every time the block is freed, so handles to the old object go stale.
+    // Wraps within the generation bits of a handle, skipping 0.
+    std::atomic<unsigned int> generation{1};
+
     // Constructor.
     MemBlock();
 
     // Creates the block with the given size.
     void create(size_t size);
 
+    // Points the block at memory owned by the pool.
+    void assign(StrPtr p_bytes, size_t size);
+
     // Clears out the block memory.
     void clear();
 
+    // Fills the block memory with a byte pattern.
+    void fill(int p_byte);
+
     // Frees the memory.
     void free_memory();
 
-    // Sets the identifier.
-    void set_identifier(CStrPtr p_identifier);
+    /**
+     * Sets the type of the object in the block.
+     * @param p_type_info
+     */
+    inline void set_type_info(const ObjectRefInfo* p_type_info) { type_info = p_type_info; }
+
+    /**
+     * Returns the type of the object in the block.
+     * @return
+     */
+    inline const ObjectRefInfo* get_type_info() const { return type_info; }
+
+    /**
+     * Returns a handle to the object currently in the block.
+     * @return
+     */
+    MemHandle get_handle() const;
+
+    /**
+     * Marks the object in the block as gone for every handle taken so far.
+     */
+    inline void retire()
+    {
+        unsigned int next = static_cast<unsigned int>((generation.load(std::memory_order_relaxed) + 1) & SYMPL_MEM_HANDLE_GENERATION_MASK);
+        generation.store(next == 0 ? 1 : next, std::memory_order_release);
+    }
 
     /**
      * Returns the identifier.
      * @return
      */
-    inline const char* get_identifier() const { return identifier; }
+    inline const char* get_identifier() const { return type_info ? type_info->get_type_name().c_str() : ""; }
 };
 
 SymplNamespaceEnd
@@ -0,0 +1,144 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#include "mem_block_table.hpp"
+#include "mem_arena.hpp"
+SymplNamespace
+
+// Bytes mapped for one segment, rounded up to whole OS pages.
+#define SYMPL_MEM_BLOCK_TABLE_SEGMENT_BYTES ((sizeof(MemBlockTableSegment) + SYMPL_MEM_ARENA_PAGE_SIZE - 1) & ~static_cast<size_t>(SYMPL_MEM_ARENA_PAGE_SIZE - 1))
+
+MemBlockTable::MemBlockTable()
+{
+    for (auto& segment : segments) {
+        segment.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+MemBlockTable::~MemBlockTable()
+{
+    clear();
+}
+
+size_t MemBlockTable::add(MemBlock* p_block, unsigned char p_size_class)
+{
+    size_t index = count.load(std::memory_order_relaxed);
+    size_t segment_index = index >> SYMPL_MEM_BLOCK_TABLE_SEGMENT_SHIFT;
+    if (segment_index >= SYMPL_MEM_BLOCK_TABLE_MAX_SEGMENTS) {
+        return static_cast<size_t>(-1);
+    }
+
+    MemBlockTableSegment* segment = segments[segment_index].load(std::memory_order_relaxed);
+    if (!segment) {
+        // Fresh mappings read as zero, so every flag starts clear without touching the pages.
+        StrPtr memory = MemArena::map_memory(SYMPL_MEM_BLOCK_TABLE_SEGMENT_BYTES, false);
+        if (!memory) {
+            return static_cast<size_t>(-1);
+        }
+        segment = new(memory) MemBlockTableSegment;
+        segments[segment_index].store(segment, std::memory_order_release);
+    }
+
+    size_t offset = get_offset(index);
+    segment->blocks[offset] = p_block;
+    segment->size_classes[offset] = p_size_class;
+    count.store(index + 1, std::memory_order_release);
+    return index;
+}
+
+size_t MemBlockTable::count_flag(unsigned char p_flag) const
+{
+    // Shift the flag down to bit 0 of every byte, then one multiply adds up the eight bytes.
+    size_t shift = count_trailing_zeros(p_flag);
+    uint64_t ones = SYMPL_MEM_BLOCK_FLAG_WORD(1);
+    size_t count_flagged = 0;
+    size_t end = end_index();
+    for (size_t base = 0; base < end; base += SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE) {
+        MemBlockTableSegment* segment = get_segment(base);
+        if (!segment) {
+            continue;
+        }
+
+        for (size_t offset = 0; offset < SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE; offset += 8) {
+            count_flagged += static_cast<size_t>((((load_flags(segment, offset) >> shift) & ones) * ones) >> 56);
+        }
+    }
+    return count_flagged;
+}
+
+size_t MemBlockTable::count_live_types(std::vector<size_t>& r_counts) const
+{
+    size_t live = 0;
+    size_t end = end_index();
+    for (size_t base = 0; base < end; base += SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE) {
+        MemBlockTableSegment* segment = get_segment(base);
+        if (!segment) {
+            continue;
+        }
+
+        for (size_t offset = 0; offset < SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE; offset += 8) {
+            uint64_t flags = load_flags(segment, offset) & SYMPL_MEM_BLOCK_FLAG_WORD(SYMPL_MEM_BLOCK_FLAG_LIVE);
+            if (!flags) {
+                continue;
+            }
+
+            const unsigned short* type_ids = segment->type_ids + offset;
+            live += static_cast<size_t>((flags * SYMPL_MEM_BLOCK_FLAG_WORD(1)) >> 56);
+            while (flags) {
+                unsigned short type_id = type_ids[count_trailing_zeros(flags) >> 3];
+                if (type_id >= r_counts.size()) {
+                    r_counts.resize(static_cast<size_t>(type_id) + 1, 0);
+                }
+                r_counts[type_id]++;
+                flags &= flags - 1;
+            }
+        }
+    }
+    return live;
+}
+
+void MemBlockTable::clear_flags()
+{
+    size_t end = end_index();
+    for (size_t base = 0; base < end; base += SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE) {
+        MemBlockTableSegment* segment = get_segment(base);
+        if (!segment) {
+            continue;
+        }
+
+        // Spread each static bit over its whole byte to keep those flags and drop the rest.
+        for (size_t offset = 0; offset < SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE; offset += 8) {
+            uint64_t flags = load_flags(segment, offset);
+            uint64_t keep = ((flags >> count_trailing_zeros(SYMPL_MEM_BLOCK_FLAG_STATIC)) & SYMPL_MEM_BLOCK_FLAG_WORD(1)) * 0xFF;
+            flags &= keep;
+            memcpy(segment->flags + offset, &flags, sizeof(flags));
+        }
+    }
+}
+
+size_t MemBlockTable::get_mapped_bytes() const
+{
+    size_t mapped = 0;
+    size_t end = end_index();
+    for (size_t base = 0; base < end; base += SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE) {
+        if (get_segment(base)) {
+            mapped += SYMPL_MEM_BLOCK_TABLE_SEGMENT_BYTES;
+        }
+    }
+    return mapped;
+}
+
+void MemBlockTable::clear()
+{
+    // Only segments up to the last index handed out were ever mapped, so a
+    // short-lived table is dropped without touching every slot.
+    size_t end = count.load(std::memory_order_relaxed);
+    size_t end_segment = std::min((end + SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE - 1) >> SYMPL_MEM_BLOCK_TABLE_SEGMENT_SHIFT, static_cast<size_t>(SYMPL_MEM_BLOCK_TABLE_MAX_SEGMENTS));
+    for (size_t i = 0; i < end_segment; ++i) {
+        MemBlockTableSegment* memory = segments[i].exchange(nullptr, std::memory_order_acq_rel);
+        if (memory) {
+            MemArena::unmap_memory(reinterpret_cast<StrPtr>(memory), SYMPL_MEM_BLOCK_TABLE_SEGMENT_BYTES);
+        }
+    }
+    count.store(0, std::memory_order_release);
+}
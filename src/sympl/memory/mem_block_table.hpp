@@ -0,0 +1,318 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include <sympl/sympl_pch.hpp>
+#include <sympl/memory/mem_handle.hpp>
+
+SymplNamespaceStart
+
+class MemBlock;
+
+// Blocks per table segment, as a power of two.
+#define SYMPL_MEM_BLOCK_TABLE_SEGMENT_SHIFT 16
+#define SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE (static_cast<size_t>(1) << SYMPL_MEM_BLOCK_TABLE_SEGMENT_SHIFT)
+// Most segments a table can hold, 268M blocks in all.
+#define SYMPL_MEM_BLOCK_TABLE_MAX_SEGMENTS 4096
+static_assert((SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE * SYMPL_MEM_BLOCK_TABLE_MAX_SEGMENTS) - 1 <= SYMPL_MEM_HANDLE_INDEX_MASK, "Handles must fit every block index");
+
+// Flag set while a block holds an object.
+#define SYMPL_MEM_BLOCK_FLAG_LIVE 0x01
+// Flag set while a block holds an object that is never freed.
+#define SYMPL_MEM_BLOCK_FLAG_STATIC 0x02
+// Flag set while a block holds an object with a __destruct hook to run when its heap is dropped.
+#define SYMPL_MEM_BLOCK_FLAG_DESTRUCT 0x04
+// A flag repeated in every byte of a word, to test 8 blocks at once.
+#define SYMPL_MEM_BLOCK_FLAG_WORD(flag) (static_cast<uint64_t>(flag) * 0x0101010101010101ULL)
+
+/**
+ * Blocks of one table segment with their metadata in parallel arrays, so a
+ * heap walk scans a few bytes per block instead of chasing headers.
+ */
+struct SYMPL_API MemBlockTableSegment
+{
+    // Block headers by offset in the segment.
+    MemBlock* blocks[SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE];
+
+    // Live, static and destruct flags of each block. A byte per block rather than a bit, so
+    // threads allocating neighbouring blocks never share a word to update.
+    unsigned char flags[SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE];
+
+    // Size class of each block, fixed when the block is carved.
+    unsigned char size_classes[SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE];
+
+    // Type id of the object in each block, 0 when the type is unknown.
+    unsigned short type_ids[SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE];
+};
+
+/**
+ * Index to block lookup for a pool. Segments never move once mapped, so any
+ * thread can look up an index without a lock while the owner keeps adding.
+ * clear() starts the indices over from 0; handles taken before it carry the
+ * pool's old heap id, so they never resolve to the new blocks.
+ */
+class SYMPL_API MemBlockTable
+{
+private:
+    // Mapped segments.
+    std::atomic<MemBlockTableSegment*> segments[SYMPL_MEM_BLOCK_TABLE_MAX_SEGMENTS];
+
+    // Index the next block gets. Published after the entry is written.
+    std::atomic<size_t> count{0};
+
+    /**
+     * Returns the segment holding an index. The index must have been handed out.
+     * @param p_index
+     * @return
+     */
+    inline MemBlockTableSegment* get_segment(size_t p_index) const
+    {
+        return segments[p_index >> SYMPL_MEM_BLOCK_TABLE_SEGMENT_SHIFT].load(std::memory_order_acquire);
+    }
+
+    /**
+     * Returns the offset of an index in its segment.
+     * @param p_index
+     * @return
+     */
+    static inline size_t get_offset(size_t p_index) { return p_index & (SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE - 1); }
+
+public:
+    /**
+     * Constructor.
+     */
+    MemBlockTable();
+
+    /**
+     * Destructor.
+     */
+    ~MemBlockTable();
+
+    MemBlockTable(const MemBlockTable&) = delete;
+    MemBlockTable& operator=(const MemBlockTable&) = delete;
+
+    /**
+     * Adds a block and returns its index, or -1 when the table is full.
+     * Callers must serialize adds and clears.
+     * @param p_block
+     * @param p_size_class
+     * @return
+     */
+    size_t add(MemBlock* p_block, unsigned char p_size_class);
+
+    /**
+     * Returns the block at an index, or nullptr if there is none.
+     * @param p_index
+     * @return
+     */
+    inline MemBlock* get(size_t p_index) const
+    {
+        if (p_index >= count.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        MemBlockTableSegment* segment = get_segment(p_index);
+        return segment ? segment->blocks[get_offset(p_index)] : nullptr;
+    }
+
+    /**
+     * Marks the block at a handed out index as holding an object.
+     * Only the thread holding the block may call this.
+     * @param p_index
+     * @param p_type_id
+     */
+    inline void set_live(size_t p_index, unsigned short p_type_id)
+    {
+        MemBlockTableSegment* segment = get_segment(p_index);
+        size_t offset = get_offset(p_index);
+        segment->type_ids[offset] = p_type_id;
+        segment->flags[offset] = SYMPL_MEM_BLOCK_FLAG_LIVE;
+    }
+
+    /**
+     * Marks the block at a handed out index as free.
+     * Only the thread holding the block may call this.
+     * @param p_index
+     * @param r_size_class Set to the size class of the block.
+     * @return false if the block was already free.
+     */
+    inline bool clear_live(size_t p_index, size_t& r_size_class)
+    {
+        MemBlockTableSegment* segment = get_segment(p_index);
+        size_t offset = get_offset(p_index);
+        r_size_class = segment->size_classes[offset];
+        if (!(segment->flags[offset] & SYMPL_MEM_BLOCK_FLAG_LIVE)) {
+            return false;
+        }
+        segment->flags[offset] = 0;
+        return true;
+    }
+
+    /**
+     * Returns whether the block at a handed out index holds an object.
+     * @param p_index
+     * @return
+     */
+    inline bool is_live(size_t p_index) const { return (get_segment(p_index)->flags[get_offset(p_index)] & SYMPL_MEM_BLOCK_FLAG_LIVE) != 0; }
+
+    /**
+     * Sets whether the live block at a handed out index holds a static object.
+     * @param p_index
+     * @param p_static
+     */
+    inline void set_static(size_t p_index, bool p_static)
+    {
+        unsigned char& flags = get_segment(p_index)->flags[get_offset(p_index)];
+        flags = p_static ? (flags | SYMPL_MEM_BLOCK_FLAG_STATIC) : (flags & ~SYMPL_MEM_BLOCK_FLAG_STATIC);
+    }
+
+    /**
+     * Returns whether the block at a handed out index holds a static object.
+     * @param p_index
+     * @return
+     */
+    inline bool is_static(size_t p_index) const { return (get_segment(p_index)->flags[get_offset(p_index)] & SYMPL_MEM_BLOCK_FLAG_STATIC) != 0; }
+
+    /**
+     * Marks the live block at a handed out index as holding an object with a __destruct hook.
+     * Only the thread holding the block may call this.
+     * @param p_index
+     */
+    inline void set_destruct(size_t p_index) { get_segment(p_index)->flags[get_offset(p_index)] |= SYMPL_MEM_BLOCK_FLAG_DESTRUCT; }
+
+    /**
+     * Returns the size class of the block at a handed out index.
+     * @param p_index
+     * @return
+     */
+    inline unsigned char get_size_class(size_t p_index) const { return get_segment(p_index)->size_classes[get_offset(p_index)]; }
+
+    /**
+     * Returns the type id of the object in the block at a handed out index.
+     * @param p_index
+     * @return
+     */
+    inline unsigned short get_type_id(size_t p_index) const { return get_segment(p_index)->type_ids[get_offset(p_index)]; }
+
+    /**
+     * Counts the blocks with a flag set.
+     * @param p_flag
+     * @return
+     */
+    size_t count_flag(unsigned char p_flag) const;
+
+    /**
+     * Counts the blocks holding an object.
+     * @return
+     */
+    inline size_t count_live() const { return count_flag(SYMPL_MEM_BLOCK_FLAG_LIVE); }
+
+    /**
+     * Counts the blocks holding a static object.
+     * @return
+     */
+    inline size_t count_static() const { return count_flag(SYMPL_MEM_BLOCK_FLAG_STATIC); }
+
+    /**
+     * Counts the blocks holding an object, by type id.
+     * @param r_counts Indexed by type id, grown to fit every id seen.
+     * @return Number of blocks counted.
+     */
+    size_t count_live_types(std::vector<size_t>& r_counts) const;
+
+    /**
+     * Calls a function with the index of every block holding an object.
+     * @tparam F
+     * @param p_function
+     */
+    template<class F>
+    inline void for_each_live(F p_function) const { for_each_flag(SYMPL_MEM_BLOCK_FLAG_LIVE, p_function); }
+
+    /**
+     * Calls a function with the index of every block with a flag set.
+     * @tparam F
+     * @param p_flag
+     * @param p_function
+     */
+    template<class F>
+    void for_each_flag(unsigned char p_flag, F p_function) const
+    {
+        size_t end = end_index();
+        for (size_t base = 0; base < end; base += SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE) {
+            MemBlockTableSegment* segment = get_segment(base);
+            if (!segment) {
+                continue;
+            }
+
+            // Eight flags at a time, most of a sparse heap is skipped a word at once.
+            for (size_t offset = 0; offset < SYMPL_MEM_BLOCK_TABLE_SEGMENT_SIZE; offset += 8) {
+                uint64_t flagged = load_flags(segment, offset) & SYMPL_MEM_BLOCK_FLAG_WORD(p_flag);
+                while (flagged) {
+                    p_function(base + offset + (count_trailing_zeros(flagged) >> 3));
+                    flagged &= flagged - 1;
+                }
+            }
+        }
+    }
+
+    /**
+     * Marks every block free, except the static ones.
+     */
+    void clear_flags();
+
+    /**
+     * Returns one past the last index handed out.
+     * @return
+     */
+    inline size_t end_index() const { return count.load(std::memory_order_acquire); }
+
+    /**
+     * Returns the number of blocks in the table.
+     * @return
+     */
+    inline size_t size() const { return end_index(); }
+
+    /**
+     * Returns the bytes mapped for segments.
+     * @return
+     */
+    size_t get_mapped_bytes() const;
+
+    /**
+     * Drops every block and hands indices out from 0 again.
+     */
+    void clear();
+
+    /**
+     * Returns the flags of eight blocks starting at an offset, one per byte.
+     * @param p_segment
+     * @param p_offset
+     * @return
+     */
+    static inline uint64_t load_flags(const MemBlockTableSegment* p_segment, size_t p_offset)
+    {
+        uint64_t flags;
+        memcpy(&flags, p_segment->flags + p_offset, sizeof(flags));
+        return flags;
+    }
+
+    /**
+     * Returns the index of the lowest set bit of a non-zero word.
+     * @param p_bits
+     * @return
+     */
+    static inline size_t count_trailing_zeros(uint64_t p_bits)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_ctzll(p_bits));
+#else
+        size_t count = 0;
+        for (; !(p_bits & 1); p_bits >>= 1) {
+            count++;
+        }
+        return count;
+#endif
+    }
+};
+
+SymplNamespaceEnd
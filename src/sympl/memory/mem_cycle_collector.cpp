@@ -0,0 +1,312 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#include "mem_cycle_collector.hpp"
+#include "managed_object.hpp"
+SymplNamespace
+
+namespace {
+    // Collector of the calling thread, null once the thread has torn it down.
+    thread_local MemCycleCollector* thread_collector = nullptr;
+    thread_local bool thread_collector_destroyed = false;
+
+    // Deletes the thread's collector when the thread exits.
+    struct ThreadCollectorGuard
+    {
+        ~ThreadCollectorGuard()
+        {
+            delete thread_collector;
+            thread_collector = nullptr;
+            thread_collector_destroyed = true;
+        }
+    };
+    thread_local ThreadCollectorGuard thread_collector_guard;
+}
+
+MemCycleCollector* MemCycleCollector::instance()
+{
+    if (!thread_collector && !thread_collector_destroyed) {
+        thread_collector = new MemCycleCollector();
+        (void)&thread_collector_guard;
+    }
+    return thread_collector;
+}
+
+void MemCycleCollector::add_candidate(ManagedObject* p_object)
+{
+    p_object->cycle_color = MemCycleColor::Purple;
+    if (p_object->cycle_buffered) {
+        return;
+    }
+
+    p_object->cycle_buffered = true;
+    p_object->cycle_buffer_index = candidates.size();
+    candidates.emplace_back(p_object);
+}
+
+void MemCycleCollector::remove_candidate(ManagedObject* p_object)
+{
+    size_t index = p_object->cycle_buffer_index;
+    p_object->cycle_buffered = false;
+    if (index >= candidates.size() || candidates[index] != p_object) {
+        return;
+    }
+
+    candidates[index] = nullptr;
+    while (!candidates.empty() && !candidates.back()) {
+        candidates.pop_back();
+    }
+}
+
+void MemCycleCollector::remove_candidates(const MemPool* p_pool)
+{
+    size_t kept = 0;
+    for (auto candidate : candidates) {
+        if (!candidate) {
+            continue;
+        }
+
+        if (candidate->mem_block && candidate->mem_block->pool == p_pool) {
+            candidate->cycle_buffered = false;
+            continue;
+        }
+
+        candidate->cycle_buffer_index = static_cast<unsigned int>(kept);
+        candidates[kept++] = candidate;
+    }
+    candidates.resize(kept);
+}
+
+size_t MemCycleCollector::collect(long long p_budget_ns)
+{
+    if (collecting) {
+        return 0;
+    }
+    collecting = true;
+
+    collect_start = std::chrono::high_resolution_clock::now();
+    collect_budget_ns = p_budget_ns;
+    collect_visits = 0;
+    budget_used = false;
+    size_t freed = 0;
+
+    do {
+        freed += collect_slice();
+    } while (!candidates.empty() && !budget_used);
+
+    long long elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - collect_start).count();
+    collecting = false;
+    num_collections++;
+    num_freed += freed;
+    last_pause_ns = elapsed_ns;
+    max_pause_ns = std::max(max_pause_ns, elapsed_ns);
+    if (p_budget_ns > 0 && elapsed_ns > p_budget_ns) {
+        num_overruns++;
+    }
+
+    return freed;
+}
+
+void MemCycleCollector::clear()
+{
+    candidates.clear();
+    roots.clear();
+    stack.clear();
+    black_stack.clear();
+    children.clear();
+    garbage.clear();
+}
+
+size_t MemCycleCollector::collect_slice()
+{
+    // Newest candidates first, so short-lived cycles are found while still cache-hot.
+    roots.clear();
+    while (roots.size() < slice_size && !candidates.empty()) {
+        ManagedObject* object = candidates.back();
+        candidates.pop_back();
+        if (object) {
+            object->cycle_buffered = false;
+            roots.emplace_back(object);
+        }
+    }
+
+    if (roots.empty()) {
+        return 0;
+    }
+
+    mark_roots();
+    scan_roots();
+    collect_roots();
+    roots.clear();
+
+    size_t freed = garbage.size();
+    free_garbage();
+    return freed;
+}
+
+bool MemCycleCollector::visit()
+{
+    if (!budget_used && collect_budget_ns > 0 && ++collect_visits % SYMPL_MEM_CYCLE_CLOCK_STRIDE == 0) {
+        long long elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - collect_start).count();
+        budget_used = elapsed_ns >= collect_budget_ns;
+    }
+    return budget_used;
+}
+
+void MemCycleCollector::trace_children(ManagedObject* p_object)
+{
+    children.clear();
+    if (!p_object->cycle_traceable) {
+        return;
+    }
+
+    tracer.children = &children;
+    tracer.clear_refs = false;
+    p_object->__trace(tracer);
+
+#ifdef SYMPL_DEBUG
+    // A reference into another heap would dangle once that heap is dropped.
+    for (auto child : children) {
+        sympl_assert(!child->mem_block || !p_object->mem_block || child->mem_block->pool == p_object->mem_block->pool);
+    }
+#endif
+}
+
+void MemCycleCollector::mark_roots()
+{
+    for (auto& root : roots) {
+        // Roots that were proven live since they were buffered need no work.
+        if (root->cycle_color != MemCycleColor::Purple || root->ref_count <= 0) {
+            root = nullptr;
+            continue;
+        }
+
+        // Out of time, the roots not marked yet wait for the next collection.
+        if (budget_used) {
+            root->cycle_buffered = true;
+            root->cycle_buffer_index = static_cast<unsigned int>(candidates.size());
+            candidates.emplace_back(root);
+            root = nullptr;
+            continue;
+        }
+
+        stack.emplace_back(root);
+        while (!stack.empty()) {
+            ManagedObject* object = stack.back();
+            stack.pop_back();
+            if (object->cycle_color == MemCycleColor::Gray) {
+                continue;
+            }
+
+            object->cycle_color = MemCycleColor::Gray;
+            visit();
+            trace_children(object);
+            for (auto child : children) {
+                child->ref_count--;
+                stack.emplace_back(child);
+            }
+        }
+    }
+}
+
+void MemCycleCollector::scan_roots()
+{
+    for (auto root : roots) {
+        if (!root) {
+            continue;
+        }
+
+        stack.emplace_back(root);
+        while (!stack.empty()) {
+            ManagedObject* object = stack.back();
+            stack.pop_back();
+            if (object->cycle_color != MemCycleColor::Gray) {
+                continue;
+            }
+
+            // Still referenced from outside the subgraph, so it and everything it reaches is live.
+            if (object->ref_count > 0) {
+                scan_black(object);
+                continue;
+            }
+
+            object->cycle_color = MemCycleColor::White;
+            visit();
+            trace_children(object);
+            stack.insert(stack.end(), children.begin(), children.end());
+        }
+    }
+}
+
+void MemCycleCollector::scan_black(ManagedObject* p_object)
+{
+    p_object->cycle_color = MemCycleColor::Black;
+    black_stack.emplace_back(p_object);
+
+    while (!black_stack.empty()) {
+        ManagedObject* object = black_stack.back();
+        black_stack.pop_back();
+
+        visit();
+        trace_children(object);
+        for (auto child : children) {
+            child->ref_count++;
+            if (child->cycle_color != MemCycleColor::Black) {
+                child->cycle_color = MemCycleColor::Black;
+                black_stack.emplace_back(child);
+            }
+        }
+    }
+}
+
+void MemCycleCollector::collect_roots()
+{
+    for (auto root : roots) {
+        if (!root || root->cycle_color != MemCycleColor::White) {
+            continue;
+        }
+
+        root->cycle_color = MemCycleColor::Garbage;
+        stack.emplace_back(root);
+        while (!stack.empty()) {
+            ManagedObject* object = stack.back();
+            stack.pop_back();
+
+            garbage.emplace_back(object);
+            visit();
+            if (object->cycle_buffered) {
+                remove_candidate(object);
+            }
+
+            trace_children(object);
+            for (auto child : children) {
+                if (child->cycle_color == MemCycleColor::White) {
+                    child->cycle_color = MemCycleColor::Garbage;
+                    stack.emplace_back(child);
+                }
+            }
+        }
+    }
+}
+
+void MemCycleCollector::free_garbage()
+{
+    // Drop the references first. Marking already subtracted them, so they are
+    // cleared without a release: live children keep the count their outside
+    // owners hold, and no garbage object is freed while another points at it.
+    tracer.children = nullptr;
+    tracer.clear_refs = true;
+    for (auto object : garbage) {
+        if (object->cycle_traceable) {
+            object->__trace(tracer);
+        }
+    }
+    tracer.clear_refs = false;
+
+    for (auto object : garbage) {
+        object->cycle_color = MemCycleColor::Black;
+        object->ref_count = 0;
+        object->free_object();
+    }
+    garbage.clear();
+}
@@ -0,0 +1,242 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include "mem_cycle_tracer.hpp"
+
+SymplNamespaceStart
+
+class ManagedObject;
+class MemPool;
+
+// Candidates buffered before a safe point starts a collection.
+#define SYMPL_MEM_CYCLE_TRIGGER_COUNT 4096
+// Candidates examined together in one slice of a collection.
+#define SYMPL_MEM_CYCLE_SLICE_SIZE 256
+// Time a collection started from a safe point may take, in nanoseconds.
+#define SYMPL_MEM_CYCLE_PAUSE_BUDGET_NS 1000000
+// Objects visited between clock reads while collecting.
+#define SYMPL_MEM_CYCLE_CLOCK_STRIDE 32
+
+/**
+ * Color of an object during cycle collection.
+ */
+enum class MemCycleColor : unsigned char
+{
+    // In use, or not examined.
+    Black = 0,
+    // Possible member of a garbage cycle.
+    Gray,
+    // Member of a garbage cycle.
+    White,
+    // Possible root of a garbage cycle.
+    Purple,
+    // Being freed by the collector.
+    Garbage
+};
+
+/**
+ * Synchronous trial-deletion cycle collector (Bacon and Rajan) for managed objects.
+ *
+ * Whenever a reference to a traceable object is released without freeing it,
+ * the object is buffered as a possible cycle root. At a safe point the
+ * collector works through the buffer a slice at a time: it subtracts the
+ * references internal to the subgraph reachable from the slice, restores the
+ * ones still reachable from outside, and frees whatever is left.
+ *
+ * Reference counts are not atomic, so there is one collector per thread and
+ * objects must stay on the thread that created them.
+ */
+class SYMPL_API MemCycleCollector
+{
+private:
+    // Possible cycle roots. Slots of objects freed since they were buffered are null.
+    std::vector<ManagedObject*> candidates;
+
+    // Scratch lists reused between collections.
+    std::vector<ManagedObject*> roots;
+    std::vector<ManagedObject*> stack;
+    std::vector<ManagedObject*> black_stack;
+    std::vector<ManagedObject*> children;
+    std::vector<ManagedObject*> garbage;
+
+    // Tracer handed to the objects being examined.
+    MemCycleTracer tracer;
+
+    // Candidates buffered before a safe point collects.
+    size_t trigger_count = SYMPL_MEM_CYCLE_TRIGGER_COUNT;
+
+    // Candidates examined per slice.
+    size_t slice_size = SYMPL_MEM_CYCLE_SLICE_SIZE;
+
+    // Time a safe point collection may take.
+    long long pause_budget_ns = SYMPL_MEM_CYCLE_PAUSE_BUDGET_NS;
+
+    // Whether a collection is running, so destructors can't start another.
+    bool collecting = false;
+
+    // Clock of the running collection.
+    std::chrono::high_resolution_clock::time_point collect_start;
+    long long collect_budget_ns = 0;
+    size_t collect_visits = 0;
+    bool budget_used = false;
+
+    // Statistics.
+    size_t num_collections = 0;
+    size_t num_freed = 0;
+    long long last_pause_ns = 0;
+    long long max_pause_ns = 0;
+    size_t num_overruns = 0;
+
+    /**
+     * Counts a visited object and reads the clock every few visits.
+     * @return Whether the budget of the running collection is used.
+     */
+    bool visit();
+
+    /**
+     * Fills the children list with the references an object reports.
+     * @param p_object
+     */
+    void trace_children(ManagedObject* p_object);
+
+    /**
+     * Subtracts internal references over the subgraph reachable from the slice.
+     */
+    void mark_roots();
+
+    /**
+     * Restores the counts of objects still referenced from outside the subgraph.
+     */
+    void scan_roots();
+
+    /**
+     * Moves the objects left white into the garbage list.
+     */
+    void collect_roots();
+
+    /**
+     * Drops the references between garbage objects and frees them.
+     */
+    void free_garbage();
+
+    /**
+     * Colors an object and everything it reaches black, restoring their counts.
+     * @param p_object
+     */
+    void scan_black(ManagedObject* p_object);
+
+    /**
+     * Runs trial deletion on the next slice of candidates.
+     * @return Objects freed.
+     */
+    size_t collect_slice();
+
+public:
+    /**
+     * Returns the collector of the calling thread, nullptr while the thread is exiting.
+     * @return
+     */
+    static MemCycleCollector* instance();
+
+    /**
+     * Buffers an object as a possible cycle root.
+     * @param p_object
+     */
+    void add_candidate(ManagedObject* p_object);
+
+    /**
+     * Unbuffers an object that is about to be freed.
+     * @param p_object
+     */
+    void remove_candidate(ManagedObject* p_object);
+
+    /**
+     * Unbuffers every object living in a pool that is about to drop its blocks.
+     * @param p_pool
+     */
+    void remove_candidates(const MemPool* p_pool);
+
+    /**
+     * Collects if enough candidates are buffered. Call where no raw pointers
+     * to managed objects are held outside of shared pointers.
+     */
+    inline void safe_point()
+    {
+        if (candidates.size() >= trigger_count) {
+            collect(pause_budget_ns);
+        }
+    }
+
+    /**
+     * Collects slices of candidates until the buffer is empty or the budget is
+     * used. The clock is read while marking, and roots a slice did not get to
+     * go back to the buffer. Once a root is marked its subgraph has to be
+     * scanned to restore the counts, so a single large subgraph can still
+     * overrun the budget.
+     * @param p_budget_ns Time budget, 0 for no limit.
+     * @return Objects freed.
+     */
+    size_t collect(long long p_budget_ns = 0);
+
+    /**
+     * Forgets every candidate without touching them. For use after the pool
+     * they live in has been wiped.
+     */
+    void clear();
+
+    /**
+     * Sets when safe points collect and how long they may pause.
+     * @param p_trigger_count
+     * @param p_pause_budget_ns
+     */
+    inline void set_trigger(size_t p_trigger_count, long long p_pause_budget_ns)
+    {
+        trigger_count = p_trigger_count;
+        pause_budget_ns = p_pause_budget_ns;
+    }
+
+    /**
+     * Sets the number of candidates examined per slice.
+     * @param p_slice_size
+     */
+    inline void set_slice_size(size_t p_slice_size) { slice_size = p_slice_size > 0 ? p_slice_size : 1; }
+
+    /**
+     * Returns the number of slots in the candidate buffer.
+     * @return
+     */
+    inline size_t get_num_candidates() const { return candidates.size(); }
+
+    /**
+     * Returns the number of collections run.
+     * @return
+     */
+    inline size_t get_num_collections() const { return num_collections; }
+
+    /**
+     * Returns the number of objects freed by the collector.
+     * @return
+     */
+    inline size_t get_num_freed() const { return num_freed; }
+
+    /**
+     * Returns how long the last collection took.
+     * @return
+     */
+    inline long long get_last_pause_ns() const { return last_pause_ns; }
+
+    /**
+     * Returns the longest collection so far.
+     * @return
+     */
+    inline long long get_max_pause_ns() const { return max_pause_ns; }
+
+    /**
+     * Returns the number of collections that took longer than their budget.
+     * @return
+     */
+    inline size_t get_num_overruns() const { return num_overruns; }
+};
+
+SymplNamespaceEnd
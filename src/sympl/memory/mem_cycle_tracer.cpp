@@ -0,0 +1,21 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#include "mem_cycle_tracer.hpp"
+#include "managed_object.hpp"
+SymplNamespace
+
+void MemCycleTracer::visit(ManagedObject* p_object)
+{
+    // Immortal objects are never freed, so they can't be part of a garbage cycle.
+    if (p_object->is_immortal()) {
+        return;
+    }
+
+    children->emplace_back(p_object);
+}
+
+bool MemCycleTracer::is_counted(ManagedObject* p_object) const
+{
+    return !p_object->is_immortal();
+}
@@ -0,0 +1,79 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include "shared_ptr.hpp"
+
+SymplNamespaceStart
+
+class ManagedObject;
+
+/**
+ * Handed to ManagedObject::__trace so an object can report the strong
+ * references it holds to the cycle collector.
+ */
+class SYMPL_API MemCycleTracer
+{
+    friend class MemCycleCollector;
+
+private:
+    // Where reported references are collected.
+    std::vector<ManagedObject*>* children = nullptr;
+
+    // Whether reported references are dropped instead of collected.
+    bool clear_refs = false;
+
+    /**
+     * Collects a reported reference, skipping static objects.
+     * @param p_object
+     */
+    void visit(ManagedObject* p_object);
+
+    /**
+     * Returns whether the collector subtracted references to an object while marking.
+     * @param p_object
+     * @return
+     */
+    bool is_counted(ManagedObject* p_object) const;
+
+public:
+    /**
+     * Reports a strong reference held by the object being traced.
+     * @tparam T
+     * @param p_ref
+     */
+    template<class T>
+    inline void operator()(SharedPtr<T>& p_ref)
+    {
+        if (!p_ref.ptr()) {
+            return;
+        }
+
+        if (clear_refs) {
+            // Marking already took this reference off the count, releasing it
+            // again would free live objects the garbage points at.
+            if (is_counted(p_ref.ptr())) {
+                p_ref.detach();
+            } else {
+                p_ref = SharedPtr<T>();
+            }
+        } else {
+            visit(p_ref.ptr());
+        }
+    }
+
+    /**
+     * Reports every strong reference in a list.
+     * @tparam T
+     * @param p_refs
+     */
+    template<class T>
+    inline void operator()(std::vector<SharedPtr<T>>& p_refs)
+    {
+        for (auto& ref : p_refs) {
+            (*this)(ref);
+        }
+    }
+};
+
+SymplNamespaceEnd
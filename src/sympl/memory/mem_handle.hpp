@@ -0,0 +1,81 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include <sympl/sympl_pch.hpp>
+
+SymplNamespaceStart
+
+// Bits of a handle holding the block index, enough for every block a pool's table can hold.
+#define SYMPL_MEM_HANDLE_INDEX_BITS 28
+// Bits of a handle holding the block generation. Block generations wrap within them.
+#define SYMPL_MEM_HANDLE_GENERATION_BITS 20
+// Bits of a handle holding the heap id of the pool. Heap ids wrap within them.
+#define SYMPL_MEM_HANDLE_HEAP_ID_BITS 16
+
+#define SYMPL_MEM_HANDLE_INDEX_MASK ((static_cast<uint64_t>(1) << SYMPL_MEM_HANDLE_INDEX_BITS) - 1)
+#define SYMPL_MEM_HANDLE_GENERATION_MASK ((static_cast<uint64_t>(1) << SYMPL_MEM_HANDLE_GENERATION_BITS) - 1)
+#define SYMPL_MEM_HANDLE_HEAP_ID_MASK ((static_cast<uint64_t>(1) << SYMPL_MEM_HANDLE_HEAP_ID_BITS) - 1)
+
+/**
+ * Compact 64-bit reference to a pool block: the block index in the low bits,
+ * then the block generation, then the heap id of the pool. A handle goes
+ * stale as soon as its block is freed, even if the block is handed out again,
+ * and once its pool is cleared, since that starts the block indices over.
+ * Generations and heap ids wrap, so a handle kept across a million reuses of
+ * its block or 65535 clears may resolve again.
+ */
+struct SYMPL_API MemHandle
+{
+    // Packed index, generation and heap id, 0 for no block.
+    uint64_t value = 0;
+
+    /**
+     * Constructor.
+     */
+    MemHandle() = default;
+
+    /**
+     * Constructor.
+     * @param p_index
+     * @param p_generation
+     * @param p_heap_id
+     */
+    MemHandle(size_t p_index, unsigned int p_generation, unsigned int p_heap_id)
+    {
+        value = (static_cast<uint64_t>(p_index) & SYMPL_MEM_HANDLE_INDEX_MASK)
+            | ((static_cast<uint64_t>(p_generation) & SYMPL_MEM_HANDLE_GENERATION_MASK) << SYMPL_MEM_HANDLE_INDEX_BITS)
+            | ((static_cast<uint64_t>(p_heap_id) & SYMPL_MEM_HANDLE_HEAP_ID_MASK) << (SYMPL_MEM_HANDLE_INDEX_BITS + SYMPL_MEM_HANDLE_GENERATION_BITS));
+    }
+
+    /**
+     * Returns the index of the block in its pool.
+     * @return
+     */
+    inline size_t get_index() const { return static_cast<size_t>(value & SYMPL_MEM_HANDLE_INDEX_MASK); }
+
+    /**
+     * Returns the generation the block had when the handle was taken.
+     * @return
+     */
+    inline unsigned int get_generation() const { return static_cast<unsigned int>((value >> SYMPL_MEM_HANDLE_INDEX_BITS) & SYMPL_MEM_HANDLE_GENERATION_MASK); }
+
+    /**
+     * Returns the heap id of the pool the block was in.
+     * @return
+     */
+    inline unsigned int get_heap_id() const { return static_cast<unsigned int>(value >> (SYMPL_MEM_HANDLE_INDEX_BITS + SYMPL_MEM_HANDLE_GENERATION_BITS)); }
+
+    /**
+     * Returns whether the handle refers to no block. Heap id 0 is never handed out.
+     * @return
+     */
+    inline bool is_null() const { return value == 0; }
+
+    inline bool operator==(const MemHandle& p_other) const { return value == p_other.value; }
+    inline bool operator!=(const MemHandle& p_other) const { return value != p_other.value; }
+};
+
+static_assert(sizeof(MemHandle) == sizeof(uint64_t), "MemHandle must stay one 64-bit word");
+
+SymplNamespaceEnd
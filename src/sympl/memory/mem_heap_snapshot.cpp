@@ -0,0 +1,215 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#include "mem_heap_snapshot.hpp"
+#include "mem_pool.hpp"
+#include "mem_alloc_tracer.hpp"
+#include "object_ref.hpp"
+#include <map>
+SymplNamespace
+
+namespace {
+    // First line of a snapshot file.
+    const char* snapshot_header = "type,count,bytes,script";
+}
+
+void MemHeapSnapshot::take(const MemPool* p_pool)
+{
+    entries.clear();
+    groups.clear();
+    num_blocks = 0;
+    total_bytes = 0;
+
+#ifdef SYMPL_TRACE_ALLOCATIONS
+    std::vector<MemAllocSite> sites;
+    MemAllocTracer::instance()->get_sites(sites);
+#endif
+
+    entries.reserve(p_pool->count_live_blocks());
+    p_pool->for_each_live_block([this
+#ifdef SYMPL_TRACE_ALLOCATIONS
+        , &sites
+#endif
+    ](MemBlock* p_block) {
+        MemHeapEntry entry;
+        entry.type_info = p_block->get_type_info();
+        entry.block_index = p_block->block_index;
+        entry.block_size = p_block->block_size;
+        // Only managed objects are carved as blocks, buffers go elsewhere.
+        entry.ref_count = reinterpret_cast<const ObjectRef*>(p_block->bytes)->ref_count;
+#ifdef SYMPL_TRACE_ALLOCATIONS
+        if (p_block->trace_site > 0 && p_block->trace_site <= sites.size()) {
+            const MemAllocSite& site = sites[p_block->trace_site - 1];
+            entry.script_file = site.script_file;
+            entry.script_line = site.script_line;
+            entry.script_column = site.script_column;
+        }
+#endif
+        entries.emplace_back(entry);
+    });
+
+    // Most blocks have no script position, those are grouped through the type id alone.
+    std::vector<size_t> type_groups;
+    std::map<std::tuple<const ObjectRefInfo*, const char*, int, int>, size_t> position_groups;
+    for (const auto& entry : entries) {
+        size_t group_index = 0;
+        if (!entry.script_file) {
+            size_t type_id = entry.type_info ? entry.type_info->get_type_id() : 0;
+            if (type_id >= type_groups.size()) {
+                type_groups.resize(type_id + 1, 0);
+            }
+            group_index = type_groups[type_id];
+            if (group_index == 0) {
+                groups.emplace_back();
+                groups.back().script_position = "-";
+                group_index = type_groups[type_id] = groups.size();
+            }
+        } else {
+            size_t& position_group = position_groups[std::make_tuple(entry.type_info, entry.script_file, entry.script_line, entry.script_column)];
+            if (position_group == 0) {
+                std::stringstream position;
+                position << entry.script_file << ":" << entry.script_line << ":" << entry.script_column;
+                groups.emplace_back();
+                groups.back().script_position = position.str();
+                position_group = groups.size();
+            }
+            group_index = position_group;
+        }
+
+        MemHeapGroup& group = groups[group_index - 1];
+        if (group.count == 0) {
+            group.type_name = entry.type_info ? entry.type_info->get_type_name() : std::string("<untyped>");
+        }
+        group.count++;
+        group.bytes += entry.block_size;
+        num_blocks++;
+        total_bytes += entry.block_size;
+    }
+
+    std::sort(groups.begin(), groups.end(), [](const MemHeapGroup& p_a, const MemHeapGroup& p_b) {
+        return p_a.bytes > p_b.bytes;
+    });
+}
+
+void MemHeapSnapshot::write(std::ostream& p_output) const
+{
+    p_output << snapshot_header << std::endl;
+    for (const auto& group : groups) {
+        p_output << group.type_name << "," << group.count << "," << group.bytes << "," << group.script_position << std::endl;
+    }
+}
+
+bool MemHeapSnapshot::write(const char* p_path) const
+{
+    std::ofstream output(p_path);
+    if (!output) {
+        return false;
+    }
+
+    write(output);
+    return static_cast<bool>(output);
+}
+
+bool MemHeapSnapshot::read(const char* p_path)
+{
+    std::ifstream input(p_path);
+    std::string line;
+    if (!input || !std::getline(input, line) || line != snapshot_header) {
+        return false;
+    }
+
+    entries.clear();
+    groups.clear();
+    num_blocks = 0;
+    total_bytes = 0;
+
+    while (std::getline(input, line)) {
+        // The script position goes last, so a file name with commas in it still reads back.
+        size_t count_start = line.find(',');
+        size_t bytes_start = count_start == std::string::npos ? count_start : line.find(',', count_start + 1);
+        size_t script_start = bytes_start == std::string::npos ? bytes_start : line.find(',', bytes_start + 1);
+        if (script_start == std::string::npos) {
+            continue;
+        }
+
+        MemHeapGroup group;
+        group.type_name = line.substr(0, count_start);
+        group.count = std::strtoull(line.c_str() + count_start + 1, nullptr, 10);
+        group.bytes = std::strtoull(line.c_str() + bytes_start + 1, nullptr, 10);
+        group.script_position = line.substr(script_start + 1);
+        num_blocks += group.count;
+        total_bytes += group.bytes;
+        groups.emplace_back(group);
+    }
+    return true;
+}
+
+void MemHeapSnapshot::get_type_totals(std::unordered_map<std::string, std::pair<size_t, size_t>>& r_totals) const
+{
+    for (const auto& group : groups) {
+        auto& totals = r_totals[group.type_name];
+        totals.first += group.count;
+        totals.second += group.bytes;
+    }
+}
+
+void MemHeapSnapshot::diff(const MemHeapSnapshot& p_before, const MemHeapSnapshot& p_after, std::vector<MemHeapTypeDelta>& r_output)
+{
+    // Types are matched by name, type ids depend on registration order and differ between runs.
+    std::unordered_map<std::string, std::pair<size_t, size_t>> before_totals;
+    std::unordered_map<std::string, std::pair<size_t, size_t>> after_totals;
+    p_before.get_type_totals(before_totals);
+    p_after.get_type_totals(after_totals);
+
+    for (const auto& after : after_totals) {
+        MemHeapTypeDelta delta;
+        delta.type_name = after.first;
+        delta.after_count = after.second.first;
+        delta.after_bytes = after.second.second;
+
+        auto before = before_totals.find(after.first);
+        if (before != before_totals.end()) {
+            delta.before_count = before->second.first;
+            delta.before_bytes = before->second.second;
+        }
+
+        delta.count_delta = static_cast<long long>(delta.after_count) - static_cast<long long>(delta.before_count);
+        delta.bytes_delta = static_cast<long long>(delta.after_bytes) - static_cast<long long>(delta.before_bytes);
+        if (delta.count_delta != 0 || delta.bytes_delta != 0) {
+            r_output.emplace_back(delta);
+        }
+    }
+
+    // Types that are gone entirely.
+    for (const auto& before : before_totals) {
+        if (after_totals.find(before.first) != after_totals.end()) {
+            continue;
+        }
+
+        MemHeapTypeDelta delta;
+        delta.type_name = before.first;
+        delta.before_count = before.second.first;
+        delta.before_bytes = before.second.second;
+        delta.count_delta = -static_cast<long long>(delta.before_count);
+        delta.bytes_delta = -static_cast<long long>(delta.before_bytes);
+        r_output.emplace_back(delta);
+    }
+
+    std::sort(r_output.begin(), r_output.end(), [](const MemHeapTypeDelta& p_a, const MemHeapTypeDelta& p_b) {
+        if (p_a.bytes_delta != p_b.bytes_delta) {
+            return p_a.bytes_delta > p_b.bytes_delta;
+        }
+        return p_a.count_delta > p_b.count_delta;
+    });
+}
+
+void MemHeapSnapshot::write_diff(const std::vector<MemHeapTypeDelta>& p_deltas, size_t p_count, std::ostream& p_output)
+{
+    p_output << "type,count_delta,bytes_delta,before_count,after_count,before_bytes,after_bytes" << std::endl;
+    for (size_t i = 0; i < p_deltas.size() && i < p_count; ++i) {
+        const MemHeapTypeDelta& delta = p_deltas[i];
+        p_output << delta.type_name << "," << delta.count_delta << "," << delta.bytes_delta << ","
+                 << delta.before_count << "," << delta.after_count << ","
+                 << delta.before_bytes << "," << delta.after_bytes << std::endl;
+    }
+}
@@ -0,0 +1,157 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include <sympl/sympl_pch.hpp>
+
+SymplNamespaceStart
+
+class MemPool;
+class ObjectRefInfo;
+
+/**
+ * A live block as seen when the snapshot was taken.
+ */
+struct SYMPL_API MemHeapEntry
+{
+    // Type of the object, null for untyped blocks.
+    const ObjectRefInfo* type_info = nullptr;
+
+    // Block the object lives in.
+    size_t block_index = 0;
+    size_t block_size = 0;
+
+    // Reference count of the object.
+    long long ref_count = 0;
+
+    // Script position the block was allocated at, null file when unknown.
+    // Only known in builds with SYMPL_TRACE_ALLOCATIONS.
+    const char* script_file = nullptr;
+    int script_line = 0;
+    int script_column = 0;
+};
+
+/**
+ * Live blocks of one type allocated at one script position.
+ */
+struct SYMPL_API MemHeapGroup
+{
+    std::string type_name;
+
+    // "file:line:column", or "-" when unknown.
+    std::string script_position;
+
+    size_t count = 0;
+    size_t bytes = 0;
+};
+
+/**
+ * Change in the live blocks of a type between two snapshots.
+ */
+struct SYMPL_API MemHeapTypeDelta
+{
+    std::string type_name;
+
+    size_t before_count = 0;
+    size_t before_bytes = 0;
+    size_t after_count = 0;
+    size_t after_bytes = 0;
+
+    long long count_delta = 0;
+    long long bytes_delta = 0;
+};
+
+/**
+ * Every live block of a pool at one point in time, for hunting leaks and
+ * bloat. Take one snapshot, run the suspect code, take another and diff them:
+ * the types that keep growing are the ones being leaked. Snapshots can be
+ * written to a file and read back, so runs can be compared from the CLI.
+ */
+class SYMPL_API MemHeapSnapshot
+{
+private:
+    // Live blocks, only filled by take().
+    std::vector<MemHeapEntry> entries;
+
+    // Blocks grouped by type and script position.
+    std::vector<MemHeapGroup> groups;
+
+    // Totals over every group.
+    size_t num_blocks = 0;
+    size_t total_bytes = 0;
+
+    /**
+     * Sums the groups of each type.
+     * @param r_totals Count and bytes by type name.
+     */
+    void get_type_totals(std::unordered_map<std::string, std::pair<size_t, size_t>>& r_totals) const;
+
+public:
+    /**
+     * Records every live block of a pool. Other threads must not be using the pool.
+     * @param p_pool
+     */
+    void take(const MemPool* p_pool);
+
+    /**
+     * Writes the groups as a table.
+     * @param p_output
+     */
+    void write(std::ostream& p_output) const;
+
+    /**
+     * Writes the groups to a file.
+     * @param p_path
+     * @return false if the file could not be written.
+     */
+    bool write(const char* p_path) const;
+
+    /**
+     * Reads groups written by write(). Entries are not stored in the file.
+     * @param p_path
+     * @return false if the file could not be read or is not a snapshot.
+     */
+    bool read(const char* p_path);
+
+    /**
+     * Returns the live blocks, empty for a snapshot read from a file.
+     * @return
+     */
+    inline const std::vector<MemHeapEntry>& get_entries() const { return entries; }
+
+    /**
+     * Returns the blocks grouped by type and script position, most bytes first.
+     * @return
+     */
+    inline const std::vector<MemHeapGroup>& get_groups() const { return groups; }
+
+    /**
+     * Returns the number of live blocks.
+     * @return
+     */
+    inline size_t get_num_blocks() const { return num_blocks; }
+
+    /**
+     * Returns the bytes of every live block.
+     * @return
+     */
+    inline size_t get_total_bytes() const { return total_bytes; }
+
+    /**
+     * Compares two snapshots by type.
+     * @param p_before
+     * @param p_after
+     * @param r_output Types that changed, most grown first.
+     */
+    static void diff(const MemHeapSnapshot& p_before, const MemHeapSnapshot& p_after, std::vector<MemHeapTypeDelta>& r_output);
+
+    /**
+     * Writes the first rows of a diff as a table.
+     * @param p_deltas
+     * @param p_count
+     * @param p_output
+     */
+    static void write_diff(const std::vector<MemHeapTypeDelta>& p_deltas, size_t p_count, std::ostream& p_output);
+};
+
+SymplNamespaceEnd
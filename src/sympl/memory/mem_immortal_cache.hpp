@@ -0,0 +1,117 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include <sympl/memory/managed_object.hpp>
+
+SymplNamespaceStart
+
+// Default range of the small integer cache.
+#define SYMPL_IMMORTAL_INT_MIN (-128)
+#define SYMPL_IMMORTAL_INT_MAX 1023
+
+/**
+ * One immortal object for every integer in a fixed range, built up front, so
+ * small integers and loop counters are handed out without allocating. The
+ * objects never change their reference count, so any thread may share them.
+ * @tparam T Managed type constructible from a long long.
+ */
+template<class T>
+class MemImmortalCache
+{
+private:
+    // Smallest and largest cached value.
+    long long min_value = 0;
+    long long max_value = -1;
+
+    // Cached objects, by value - min_value.
+    std::vector<T*> objects;
+
+public:
+    /**
+     * Constructor. Builds nothing.
+     */
+    MemImmortalCache() = default;
+
+    /**
+     * Constructor.
+     * @param p_min_value
+     * @param p_max_value
+     */
+    MemImmortalCache(long long p_min_value, long long p_max_value)
+    {
+        build(p_min_value, p_max_value);
+    }
+
+    MemImmortalCache(const MemImmortalCache&) = delete;
+    MemImmortalCache& operator=(const MemImmortalCache&) = delete;
+
+    /**
+     * Creates an immortal object for every value in a range. Objects of an
+     * earlier build stay alive, they are only forgotten.
+     * @param p_min_value
+     * @param p_max_value
+     * @return false if the pool ran out of memory; the cache is left empty.
+     */
+    bool build(long long p_min_value, long long p_max_value)
+    {
+        objects.clear();
+        min_value = 0;
+        max_value = -1;
+        if (p_max_value < p_min_value) {
+            return true;
+        }
+
+        std::vector<T*> values;
+        values.reserve(static_cast<size_t>(p_max_value - p_min_value + 1));
+        for (long long value = p_min_value; value <= p_max_value; ++value) {
+            T* object = ManagedObject::make_immortal<T>(value).ptr();
+            if (!object) {
+                return false;
+            }
+            values.emplace_back(object);
+        }
+
+        objects.swap(values);
+        min_value = p_min_value;
+        max_value = p_max_value;
+        return true;
+    }
+
+    /**
+     * Returns whether a value has a cached object.
+     * @param p_value
+     * @return
+     */
+    inline bool contains(long long p_value) const { return p_value >= min_value && p_value <= max_value; }
+
+    /**
+     * Returns the cached object for a value, nullptr if the value is out of range.
+     * @param p_value
+     * @return
+     */
+    inline T* get(long long p_value) const
+    {
+        return contains(p_value) ? objects[static_cast<size_t>(p_value - min_value)] : nullptr;
+    }
+
+    /**
+     * Returns the number of cached objects.
+     * @return
+     */
+    inline size_t size() const { return objects.size(); }
+
+    /**
+     * Returns the smallest cached value.
+     * @return
+     */
+    inline long long get_min_value() const { return min_value; }
+
+    /**
+     * Returns the largest cached value.
+     * @return
+     */
+    inline long long get_max_value() const { return max_value; }
+};
+
+SymplNamespaceEnd
@@ -0,0 +1,122 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#include "mem_large_object_space.hpp"
+SymplNamespace
+
+MemLargeObjectSpace::~MemLargeObjectSpace()
+{
+    release();
+}
+
+MemBlock* MemLargeObjectSpace::pop_free_header()
+{
+    MemBlock* block = free_headers;
+    if (!block) {
+        return nullptr;
+    }
+
+    free_headers = block->next_free;
+    block->next_free = nullptr;
+    return block;
+}
+
+bool MemLargeObjectSpace::map_block(MemBlock* p_block, size_t p_size)
+{
+    size_t mapping_size = get_mapping_size(p_size);
+    StrPtr bytes = MemArena::map_memory(mapping_size, false);
+    if (!bytes) {
+        p_block->next_free = free_headers;
+        free_headers = p_block;
+        return false;
+    }
+
+    p_block->assign(bytes, mapping_size);
+    p_block->page_index = static_cast<unsigned int>(live_blocks.size());
+    live_blocks.emplace_back(p_block);
+
+    block_bytes += mapping_size;
+    peak_bytes = std::max(peak_bytes, get_mapped_bytes());
+    return true;
+}
+
+size_t MemLargeObjectSpace::unmap_block(MemBlock* p_block)
+{
+    size_t mapping_size = p_block->block_size;
+    MemArena::unmap_memory(p_block->bytes, mapping_size);
+    p_block->bytes = nullptr;
+    p_block->block_size = 0;
+
+    // Move the last block into the freed slot.
+    MemBlock* last = live_blocks.back();
+    live_blocks[p_block->page_index] = last;
+    last->page_index = p_block->page_index;
+    live_blocks.pop_back();
+
+    p_block->next_free = free_headers;
+    free_headers = p_block;
+
+    block_bytes -= mapping_size;
+    return mapping_size;
+}
+
+size_t MemLargeObjectSpace::unmap_blocks()
+{
+    // Walk backwards, so the block swapped into a freed slot was already seen.
+    size_t released = 0;
+    for (size_t i = live_blocks.size(); i > 0; --i) {
+        MemBlock* block = live_blocks[i - 1];
+        if (block->is_static) {
+            continue;
+        }
+
+        block->retire();
+        released += unmap_block(block);
+    }
+    return released;
+}
+
+StrPtr MemLargeObjectSpace::map_buffer(size_t p_size)
+{
+    size_t mapping_size = get_mapping_size(p_size);
+    StrPtr buffer = MemArena::map_memory(mapping_size, false);
+    if (!buffer) {
+        return nullptr;
+    }
+
+    live_buffers[buffer] = mapping_size;
+    buffer_bytes += mapping_size;
+    peak_bytes = std::max(peak_bytes, get_mapped_bytes());
+    return buffer;
+}
+
+size_t MemLargeObjectSpace::unmap_buffer(StrPtr p_buffer)
+{
+    auto entry = live_buffers.find(p_buffer);
+    if (entry == live_buffers.end()) {
+        return 0;
+    }
+
+    size_t mapping_size = entry->second;
+    MemArena::unmap_memory(p_buffer, mapping_size);
+    live_buffers.erase(entry);
+
+    buffer_bytes -= mapping_size;
+    return mapping_size;
+}
+
+void MemLargeObjectSpace::release()
+{
+    for (auto& block : live_blocks) {
+        MemArena::unmap_memory(block->bytes, block->block_size);
+    }
+    for (auto& buffer : live_buffers) {
+        MemArena::unmap_memory(buffer.first, buffer.second);
+    }
+
+    live_blocks.clear();
+    live_buffers.clear();
+    free_headers = nullptr;
+    block_bytes = 0;
+    buffer_bytes = 0;
+}
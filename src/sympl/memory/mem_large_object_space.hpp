@@ -0,0 +1,148 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include <sympl/memory/mem_arena.hpp>
+#include <sympl/memory/mem_block.hpp>
+
+SymplNamespaceStart
+
+// Size class index marking a block that lives in the large object space.
+#define SYMPL_MEM_POOL_LARGE_CLASS_INDEX 0xFF
+// Default size past which blocks get their own mapping.
+#define SYMPL_MEM_POOL_LARGE_OBJECT_THRESHOLD (32 * 1024)
+
+/**
+ * Blocks and buffers too big for the size classes. Each one gets a mapping
+ * of its own, rounded up to whole OS pages, that is unmapped as soon as it
+ * is freed, so large allocations never leave odd-sized blocks in the pool.
+ * Not thread safe, the owning pool guards it with its central lock.
+ */
+class SYMPL_API MemLargeObjectSpace
+{
+private:
+    // Live large blocks. Each block keeps its slot in page_index, so removal is a swap with the last one.
+    std::vector<MemBlock*> live_blocks;
+
+    // Headers of freed large blocks, linked through next_free. Headers are reused
+    // rather than given back, so stale handles still resolve to a retired block.
+    MemBlock* free_headers = nullptr;
+
+    // Live raw buffers and their mapping sizes.
+    std::unordered_map<StrPtr, size_t> live_buffers;
+
+    // Bytes mapped for live blocks and for live buffers.
+    size_t block_bytes = 0;
+    size_t buffer_bytes = 0;
+
+    // Highest mapped bytes seen.
+    size_t peak_bytes = 0;
+
+public:
+    /**
+     * Constructor.
+     */
+    MemLargeObjectSpace() = default;
+
+    /**
+     * Destructor. Unmaps everything still live.
+     */
+    ~MemLargeObjectSpace();
+
+    MemLargeObjectSpace(const MemLargeObjectSpace&) = delete;
+    MemLargeObjectSpace& operator=(const MemLargeObjectSpace&) = delete;
+
+    /**
+     * Takes a header left behind by a freed large block, nullptr if there is none.
+     * @return
+     */
+    MemBlock* pop_free_header();
+
+    /**
+     * Maps the bytes of a large block and starts tracking it.
+     * @param p_block Fresh or reused header, already in the pool's block table.
+     * @param p_size
+     * @return false if the OS is out of memory; the header goes back to the free headers.
+     */
+    bool map_block(MemBlock* p_block, size_t p_size);
+
+    /**
+     * Unmaps the bytes of a large block and keeps its header for reuse.
+     * @param p_block
+     * @return Bytes unmapped.
+     */
+    size_t unmap_block(MemBlock* p_block);
+
+    /**
+     * Unmaps every live block that is not static, retiring its handles.
+     * @return Bytes unmapped.
+     */
+    size_t unmap_blocks();
+
+    /**
+     * Maps a raw buffer. The memory reads as zero.
+     * @param p_size
+     * @return
+     */
+    StrPtr map_buffer(size_t p_size);
+
+    /**
+     * Unmaps a raw buffer returned by map_buffer.
+     * @param p_buffer
+     * @return Bytes unmapped, 0 if the buffer is not tracked.
+     */
+    size_t unmap_buffer(StrPtr p_buffer);
+
+    /**
+     * Unmaps everything and forgets the block headers, which live in the pool's arena.
+     */
+    void release();
+
+    /**
+     * Returns the number of live large blocks.
+     * @return
+     */
+    inline size_t get_num_blocks() const { return live_blocks.size(); }
+
+    /**
+     * Returns the number of live raw buffers.
+     * @return
+     */
+    inline size_t get_num_buffers() const { return live_buffers.size(); }
+
+    /**
+     * Returns the bytes mapped for live blocks.
+     * @return
+     */
+    inline size_t get_block_bytes() const { return block_bytes; }
+
+    /**
+     * Returns the bytes mapped for live raw buffers.
+     * @return
+     */
+    inline size_t get_buffer_bytes() const { return buffer_bytes; }
+
+    /**
+     * Returns the bytes currently mapped.
+     * @return
+     */
+    inline size_t get_mapped_bytes() const { return block_bytes + buffer_bytes; }
+
+    /**
+     * Returns the highest mapped bytes seen.
+     * @return
+     */
+    inline size_t get_peak_bytes() const { return peak_bytes; }
+
+    /**
+     * Returns the size of the mapping a request gets.
+     * @param p_size
+     * @return
+     */
+    static inline size_t get_mapping_size(size_t p_size)
+    {
+        return (p_size + SYMPL_MEM_ARENA_PAGE_SIZE - 1) & ~static_cast<size_t>(SYMPL_MEM_ARENA_PAGE_SIZE - 1);
+    }
+};
+
+SymplNamespaceEnd
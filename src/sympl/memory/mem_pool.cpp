@@ -5,149 +5,1011 @@
 //
 #include <sympl/memory/mem_pool.hpp>
 #include <sympl/memory/mem_block.hpp>
+#include <sympl/memory/mem_thread_cache.hpp>
 #include <sympl/memory/managed_object.hpp>
+#include <sympl/memory/mem_alloc_tracer.hpp>
 SymplNamespaceStart
 
-MemPool::MemPool() {
-    default_block_size = 256; // Updated to snake_case
-    alloc_blocks(2000); // Method name updated
+namespace {
+
+// Guards the registry of live pools.
+std::mutex& get_pool_registry_lock()
+{
+    static std::mutex lock;
+    return lock;
+}
+
+// Live pools by uid, so exiting threads can find the pool for their caches.
+std::unordered_map<unsigned long long, MemPool*>& get_pool_registry()
+{
+    static std::unordered_map<unsigned long long, MemPool*> registry;
+    return registry;
+}
+
+// Next pool uid. Uids are never reused.
+std::atomic<unsigned long long> next_pool_uid(1);
+
+// Next heap id, handed out when a pool is created and every time it is cleared.
+std::atomic<unsigned int> next_heap_id(1);
+
+unsigned int new_heap_id()
+{
+    // Heap ids wrap within the handle bits. 0 marks a null handle, skip it when the counter wraps.
+    unsigned int heap_id = static_cast<unsigned int>(next_heap_id.fetch_add(1, std::memory_order_relaxed) & SYMPL_MEM_HANDLE_HEAP_ID_MASK);
+    return heap_id != 0 ? heap_id : static_cast<unsigned int>(next_heap_id.fetch_add(1, std::memory_order_relaxed) & SYMPL_MEM_HANDLE_HEAP_ID_MASK);
+}
+
+/**
+ * Size classes handed out to types, shared by every pool.
+ */
+struct SlabRegistry
+{
+    // Guards registration.
+    std::mutex lock;
+
+    // Next free slab class.
+    size_t next_class_index = SYMPL_MEM_POOL_NUM_SIZE_CLASSES;
+
+    // Block size of each slab class.
+    size_t block_sizes[SYMPL_MEM_POOL_MAX_SIZE_CLASSES] = {};
+
+    // Type each slab class belongs to.
+    const ObjectRefInfo* type_infos[SYMPL_MEM_POOL_MAX_SIZE_CLASSES] = {};
+};
+
+SlabRegistry& get_slab_registry()
+{
+    static SlabRegistry registry;
+    return registry;
+}
+
+/**
+ * Thread caches owned by the current thread, flushed back on thread exit.
+ */
+struct ThreadCacheList
+{
+    // Every cache this thread created, by pool uid.
+    std::vector<std::pair<unsigned long long, MemThreadCache*>> caches;
+
+    ~ThreadCacheList()
+    {
+        std::lock_guard<std::mutex> lock(get_pool_registry_lock());
+        auto& registry = get_pool_registry();
+
+        for (const auto& entry : caches) {
+            auto pool = registry.find(entry.first);
+            if (pool != registry.end()) {
+                pool->second->release_thread_cache(entry.second);
+            }
+        }
+    }
+};
+
+thread_local ThreadCacheList thread_cache_list;
+
+// Last pool looked up by this thread and its cache. Kept as plain values
+// so the fast path does not go through the thread_local init wrapper.
+thread_local unsigned long long thread_last_pool_uid = 0;
+thread_local MemThreadCache* thread_last_cache = nullptr;
+
+/**
+ * Config for the shared instance, fixed once the instance is created.
+ */
+struct InstanceConfig
+{
+    std::mutex lock;
+    MemPoolConfig config;
+    bool locked = false;
+};
+
+InstanceConfig& get_instance_config()
+{
+    static InstanceConfig instance_config;
+    return instance_config;
+}
+
+}
+
+thread_local MemPool* MemPool::current_pool = nullptr;
+
+MemPool::MemPool(const MemPoolConfig& p_config) {
+    default_block_size = p_config.default_block_size; // Updated to snake_case
+    page_size = p_config.page_size;
+    large_object_threshold = p_config.large_object_threshold;
+    fill_mode = p_config.fill_mode;
+    pool_uid = next_pool_uid++;
+    heap_id = new_heap_id();
+
+    arena.set_chunk_size(p_config.chunk_size);
+    arena.set_growth(p_config.growth_factor, p_config.max_chunk_size);
+    arena.set_max_reserved_bytes(p_config.max_size);
+    arena.set_use_huge_pages(p_config.use_huge_pages);
+
+    soft_limit = p_config.soft_limit_bytes;
+    hard_limit = p_config.hard_limit_bytes;
+    trim_high_watermark = p_config.trim_high_watermark_bytes;
+    trim_low_watermark = std::min(p_config.trim_low_watermark_bytes, p_config.trim_high_watermark_bytes);
+
+    for (size_t i = 0; i < SYMPL_MEM_POOL_NUM_SIZE_CLASSES; ++i) {
+        size_classes[i].block_size = get_size_class_block_size(i);
+    }
+
+    // Make sure the registry outlives the pool.
+    get_slab_registry();
+
+    {
+        std::lock_guard<std::mutex> lock(get_pool_registry_lock());
+        get_pool_registry()[pool_uid] = this;
+    }
+
+    std::lock_guard<std::mutex> lock(central_lock);
+    arena.reserve(p_config.initial_reserve_bytes);
+
+    for (size_t i = 0; i < SYMPL_MEM_POOL_NUM_SIZE_CLASSES; ++i) {
+        while (size_classes[i].free_count < p_config.prewarm_blocks[i]) {
+            if (!new_page(i)) {
+                break;
+            }
+        }
+    }
+}
+
+MemPool::~MemPool() {
+#ifdef SYMPL_DEBUG
+    // Weak pointers resolve through the pool, they can't outlive it.
+    sympl_assert(num_weak_refs.load(std::memory_order_relaxed) == 0);
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(get_pool_registry_lock());
+        get_pool_registry().erase(pool_uid);
+    }
+
+    for (auto& cache : thread_caches) {
+        delete cache;
+    }
+    thread_caches.clear();
+
+    clear();
+}
+
+bool MemPool::configure(const MemPoolConfig& p_config) {
+    InstanceConfig& instance_config = get_instance_config();
+    std::lock_guard<std::mutex> lock(instance_config.lock);
+
+    if (instance_config.locked) {
+        return false;
+    }
+
+    instance_config.config = p_config;
+    return true;
+}
+
+const MemPoolConfig& MemPool::lock_instance_config() {
+    InstanceConfig& instance_config = get_instance_config();
+    std::lock_guard<std::mutex> lock(instance_config.lock);
+
+    instance_config.locked = true;
+    return instance_config.config;
+}
+
+void MemPool::set_use_huge_pages(bool p_use_huge_pages) {
+    std::lock_guard<std::mutex> lock(central_lock);
+    arena.set_use_huge_pages(p_use_huge_pages);
+}
+
+size_t MemPool::get_reserved_bytes() const {
+    std::lock_guard<std::mutex> lock(central_lock);
+    return arena.get_reserved_bytes() + large_objects.get_mapped_bytes();
 }
 
 void MemPool::alloc_blocks(const int num_blocks) { // Method name and variable updated to snake_case
-    for (int i = 0; i < num_blocks; ++i) {
-        auto block = create_block(default_block_size); // Variable name updated
-        block->active = false; // Attribute name updated
+    std::lock_guard<std::mutex> lock(central_lock);
+
+    size_t class_index = get_size_class_index(default_block_size);
+    size_t target_count = size_classes[class_index].free_count + static_cast<size_t>(num_blocks);
+    while (size_classes[class_index].free_count < target_count) {
+        if (!new_page(class_index)) {
+            break;
+        }
+    }
+}
+
+MemBlock* MemPool::take_block(size_t p_class_index, size_t p_block_size, const ObjectRefInfo* p_type_info) {
+    MemBlock* block = get_thread_cache()->pop_block(p_class_index);
+    if (!block) {
+        return nullptr;
+    }
+    // The requested size is only checked in debug builds.
+    (void)p_block_size;
+    sympl_assert(block->block_size >= p_block_size);
+
+    if (fill_mode == MemFillMode::Zero) {
+        block->clear();
+    } else if (fill_mode == MemFillMode::Poison) {
+        block->fill(SYMPL_MEM_BLOCK_ALLOC_POISON);
     }
+
+    blocks.set_live(block->block_index, p_type_info ? p_type_info->get_type_id() : 0);
+    return block;
 }
 
 MemBlock* MemPool::create_block(const size_t block_size) { // Method name and variable updated to snake_case
-    MemBlock* block = find_valid_inactive_block(block_size); // Variable name updated
+    MemBlock* block = nullptr;
+    if (is_large_size(block_size)) {
+        block = create_large_block(block_size, nullptr);
+    } else {
+        size_t class_index = get_size_class_index(block_size);
+        sympl_assert(class_index < SYMPL_MEM_POOL_NUM_SIZE_CLASSES);
+        block = take_block(class_index, block_size, nullptr);
+    }
 
-    if (!block) {
-        block = new MemBlock();
-        block->create(block_size); // Method name updated
+    SYMPL_TRACE_ALLOC(block, nullptr);
+    return block;
+}
 
-        block->block_index = blocks.size(); // Attribute name updated
-        blocks.emplace_back(block); // Attribute name updated
+MemBlock* MemPool::create_block(const size_t block_size, const ObjectRefInfo* p_type_info) {
+    MemBlock* block = nullptr;
+    if (is_large_size(block_size)) {
+        // Large types skip their slab, a slab of them would be as sparse as the size classes.
+        block = create_large_block(block_size, p_type_info);
+    } else {
+        size_t class_index = p_type_info ? get_slab_class_index(p_type_info, block_size) : get_size_class_index(block_size);
+        sympl_assert(class_index < SYMPL_MEM_POOL_MAX_SIZE_CLASSES);
+        block = take_block(class_index, block_size, p_type_info);
     }
 
-    sympl_assert(block->block_size >= block_size); // Use sympl_assert, Attribute and variable name updated
+    SYMPL_TRACE_ALLOC(block, p_type_info);
+    return block;
+}
+
+MemBlock* MemPool::create_large_block(size_t p_block_size, const ObjectRefInfo* p_type_info) {
+    MemBudgetCallback callback;
+    size_t callback_committed_bytes = 0;
+    MemBlock* block = nullptr;
 
-    block->clear(); // Method name updated
-    block->active = true; // Attribute name updated
+    {
+        std::lock_guard<std::mutex> lock(central_lock);
+
+        size_t mapping_size = MemLargeObjectSpace::get_mapping_size(p_block_size);
+        if (!commit_locked(mapping_size, callback, callback_committed_bytes)) {
+            return nullptr;
+        }
+
+        // Headers live in the arena with the rest, so handles into freed large blocks stay safe to resolve.
+        block = large_objects.pop_free_header();
+        if (!block) {
+            auto header = static_cast<MemBlock*>(arena.allocate(sizeof(MemBlock), alignof(MemBlock)));
+            if (header) {
+                block = new(header) MemBlock();
+                block->pool = this;
+                block->block_index = blocks.add(block, SYMPL_MEM_POOL_LARGE_CLASS_INDEX);
+                if (block->block_index == static_cast<size_t>(-1)) {
+                    block = nullptr;
+                }
+            }
+        }
+
+        if (!block || !large_objects.map_block(block, p_block_size)) {
+            uncommit_locked(mapping_size);
+            return nullptr;
+        }
+    }
+
+    // Fire outside the lock so the host may allocate or free from the callback.
+    if (callback) {
+        callback(this, callback_committed_bytes, soft_limit);
+    }
+
+    // Fresh mappings already read as zero.
+    if (fill_mode == MemFillMode::Poison) {
+        block->fill(SYMPL_MEM_BLOCK_ALLOC_POISON);
+    }
+
+    blocks.set_live(block->block_index, p_type_info ? p_type_info->get_type_id() : 0);
     return block;
 }
 
+void MemPool::free_large_block(MemBlock* p_block) {
+    std::lock_guard<std::mutex> lock(central_lock);
+    uncommit_locked(large_objects.unmap_block(p_block));
+}
+
+StrPtr MemPool::alloc_large_buffer(size_t p_size) {
+    MemBudgetCallback callback;
+    size_t callback_committed_bytes = 0;
+    StrPtr buffer = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(central_lock);
+
+        size_t mapping_size = MemLargeObjectSpace::get_mapping_size(p_size);
+        if (!commit_locked(mapping_size, callback, callback_committed_bytes)) {
+            return nullptr;
+        }
+
+        buffer = large_objects.map_buffer(p_size);
+        if (!buffer) {
+            uncommit_locked(mapping_size);
+            return nullptr;
+        }
+    }
+
+    if (callback) {
+        callback(this, callback_committed_bytes, soft_limit);
+    }
+    return buffer;
+}
+
+void MemPool::free_large_buffer(StrPtr p_buffer) {
+    if (!p_buffer) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(central_lock);
+    uncommit_locked(large_objects.unmap_buffer(p_buffer));
+}
+
+size_t MemPool::get_large_object_count() const {
+    std::lock_guard<std::mutex> lock(central_lock);
+    return large_objects.get_num_blocks() + large_objects.get_num_buffers();
+}
+
+size_t MemPool::get_large_object_bytes() const {
+    std::lock_guard<std::mutex> lock(central_lock);
+    return large_objects.get_mapped_bytes();
+}
+
+bool MemPool::commit_locked(size_t p_bytes, MemBudgetCallback& r_callback, size_t& r_committed_bytes) {
+    size_t committed = committed_bytes.load(std::memory_order_relaxed) + p_bytes;
+    size_t limit = hard_limit.load(std::memory_order_relaxed);
+    if (limit > 0 && committed > limit) {
+        hard_limit_reached = true;
+        return false;
+    }
+
+    committed_bytes.store(committed, std::memory_order_relaxed);
+
+    if (soft_limit > 0 && soft_limit_armed && committed >= soft_limit) {
+        soft_limit_armed = false;
+        r_callback = soft_limit_callback;
+        r_committed_bytes = committed;
+    }
+    return true;
+}
+
+void MemPool::uncommit_locked(size_t p_bytes) {
+    size_t committed = committed_bytes.load(std::memory_order_relaxed) - p_bytes;
+    committed_bytes.store(committed, std::memory_order_relaxed);
+
+    size_t limit = hard_limit.load(std::memory_order_relaxed);
+    if (limit == 0 || committed < limit) {
+        hard_limit_reached = false;
+    }
+    if (committed < soft_limit) {
+        soft_limit_armed = true;
+    }
+}
+
 void MemPool::free_block(const MemBlock* p_block) { // Method name and parameter name updated
     if (!p_block || p_block->block_index == static_cast<size_t>(-1) || p_block->is_static) { // Condition and attribute names updated
         return;
     }
 
-    sympl_assert(p_block->block_index < blocks.size()); // Use sympl_assert, Attribute name updated
+    // The caller owns the block, so there is no need to look it up in the shared block list.
+    auto block = const_cast<MemBlock*>(p_block);
+    size_t class_index = 0;
+    if (!blocks.clear_live(block->block_index, class_index) || releasing) {
+        return;
+    }
 
-    MemBlock* block = blocks[p_block->block_index]; // Variable name updated
-    block->active = false; // Attribute name updated
     block->is_static = false; // Attribute name updated
+    block->retire();
+    SYMPL_TRACE_FREE(block);
     reinterpret_cast<ManagedObject*>(block->bytes)->~ManagedObject(); // Attribute name updated
-    block->clear(); // Method name updated
+    if (class_index == SYMPL_MEM_POOL_LARGE_CLASS_INDEX) {
+        free_large_block(block);
+        return;
+    }
+    if (fill_mode == MemFillMode::Poison) {
+        block->fill(SYMPL_MEM_BLOCK_FREE_POISON);
+    }
+    get_thread_cache()->push_block(block, class_index);
+}
+
+MemBlock* MemPool::resolve(MemHandle p_handle) const {
+    if (p_handle.get_heap_id() != heap_id.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    // Blocks that were never handed out still have a first generation to match against.
+    MemBlock* block = blocks.get(p_handle.get_index());
+    if (!block || !blocks.is_live(p_handle.get_index()) || block->generation.load(std::memory_order_acquire) != p_handle.get_generation()) {
+        return nullptr;
+    }
+    return block;
+}
+
+void MemPool::set_static(MemBlock* p_block, bool p_static) {
+    p_block->is_static = p_static;
+    blocks.set_static(p_block->block_index, p_static);
+}
+
+size_t MemPool::count_live_blocks() const {
+    std::lock_guard<std::mutex> lock(central_lock);
+    return blocks.count_live();
+}
+
+size_t MemPool::count_static_blocks() const {
+    std::lock_guard<std::mutex> lock(central_lock);
+    return blocks.count_static();
+}
+
+size_t MemPool::count_live_types(std::vector<size_t>& r_counts) const {
+    std::lock_guard<std::mutex> lock(central_lock);
+    return blocks.count_live_types(r_counts);
+}
+
+void MemPool::destruct_objects(bool p_include_static) {
+    releasing = true;
+    blocks.for_each_flag(SYMPL_MEM_BLOCK_FLAG_DESTRUCT, [this, p_include_static](size_t p_index) {
+        // An earlier hook may have released this object already.
+        if (!blocks.is_live(p_index) || (!p_include_static && blocks.is_static(p_index))) {
+            return;
+        }
+        reinterpret_cast<ManagedObject*>(blocks.get(p_index)->bytes)->__destruct();
+    });
+    releasing = false;
 }
 
 void MemPool::free_all_blocks() {
-    for (auto& block : blocks) { // Variable name updated
-        block->active = false; // Attribute name updated
-        block->is_static = false; // Attribute name updated
-        block->clear(); // Method name updated
+    destruct_objects(false);
+
+    std::lock_guard<std::mutex> lock(central_lock);
+
+    // Buffered cycle candidates and queued releases in this pool are about to become dangling.
+    MemCycleCollector* collector = MemCycleCollector::instance();
+    if (collector) {
+        collector->remove_candidates(this);
+    }
+    MemReleaseQueue* release_queue = MemReleaseQueue::instance();
+    if (release_queue) {
+        release_queue->remove_objects(this);
+    }
+
+    fold_peak_counts();
+    for (auto& cache : thread_caches) {
+        cache->reset();
+    }
+    for (auto& size_class : size_classes) {
+        size_class.reset();
+    }
+
+    // Pages trimmed earlier stay given back, their blocks were all free already.
+    for (auto& page : pages) {
+        page.central_free = page.num_blocks;
     }
+    central_free_bytes = total_block_bytes.load(std::memory_order_relaxed);
+
+    // Large buffers are not blocks, whoever holds them frees them.
+    large_objects.unmap_blocks();
+    hard_limit_reached = false;
+    soft_limit_armed = true;
+    retired_live_blocks = 0;
+    retired_live_bytes = 0;
+
+    // Immortal objects outlive the reset and keep their blocks, counted as left behind by a thread.
+    size_t immortal_bytes = 0;
+    for (size_t i = 0; i < blocks.end_index(); ++i) {
+        MemBlock* block = blocks.get(i);
+        size_t class_index = block ? blocks.get_size_class(i) : SYMPL_MEM_POOL_LARGE_CLASS_INDEX;
+        if (class_index == SYMPL_MEM_POOL_LARGE_CLASS_INDEX) {
+            continue;
+        }
+
+        if (block->is_static) {
+            size_classes[class_index].add_live(1);
+            pages[block->page_index].central_free--;
+            central_free_bytes -= block->block_size;
+            immortal_bytes += block->block_size;
+            retired_live_blocks++;
+            continue;
+        }
+
+        // Blocks go out uninitialized unless the fill mode says otherwise, and
+        // writing to a purged page would fault it back in.
+        block->retire();
+        if (fill_mode == MemFillMode::Poison && !pages[block->page_index].purged) {
+            block->fill(SYMPL_MEM_BLOCK_FREE_POISON);
+        }
+        size_classes[class_index].push(block);
+    }
+    blocks.clear_flags();
+
+    retired_live_bytes = static_cast<long long>(immortal_bytes);
+    committed_bytes = large_objects.get_mapped_bytes() + immortal_bytes;
 }
 
 void MemPool::clear() {
-    for (auto& block : blocks) { // Variable name updated
-        block->free_memory(); // Method name updated
-        delete block;
+    destruct_objects(true);
+
+    std::lock_guard<std::mutex> lock(central_lock);
+
+    MemCycleCollector* collector = MemCycleCollector::instance();
+    if (collector) {
+        collector->remove_candidates(this);
+    }
+    MemReleaseQueue* release_queue = MemReleaseQueue::instance();
+    if (release_queue) {
+        release_queue->remove_objects(this);
     }
 
+    // Block headers and bytes live in the arena, so one release drops everything.
+    // Block indices start over, so handles into the old blocks get a new heap id to fail against.
+    heap_id.store(new_heap_id(), std::memory_order_release);
     blocks.clear(); // Attribute name updated
+    large_objects.release();
+    arena.release();
+    pages.clear();
+    central_free_bytes = 0;
+    purged_bytes = 0;
+
+    fold_peak_counts();
+    for (auto& cache : thread_caches) {
+        cache->reset();
+    }
+    for (auto& size_class : size_classes) {
+        size_class.reset();
+    }
+
+    committed_bytes = 0;
+    hard_limit_reached = false;
+    soft_limit_armed = true;
+    retired_live_blocks = 0;
+    retired_live_bytes = 0;
+    total_blocks = 0;
+    total_block_bytes = 0;
 }
 
 size_t MemPool::total_mem_usage() const { // Method name updated
-    size_t total = 0;
-    for (const auto& block : blocks) { // Variable name updated
-        total += block->block_size; // Attribute name updated
+    return total_block_bytes.load(std::memory_order_relaxed);
+}
+
+bool MemPool::is_max_mem_usage() const {
+    if (hard_limit_reached.load(std::memory_order_relaxed)) {
+        return true;
     }
 
-    return total;
+    size_t limit = hard_limit.load(std::memory_order_relaxed);
+    return limit > 0 && committed_bytes.load(std::memory_order_relaxed) >= limit;
 }
 
-bool MemPool::is_max_mem_usage() const {
-    // Implementation might need to consider maximum memory usage logic
-    return false;
+void MemPool::set_soft_limit(size_t p_limit_bytes, MemBudgetCallback p_callback) {
+    std::lock_guard<std::mutex> lock(central_lock);
+
+    soft_limit = p_limit_bytes;
+    soft_limit_callback = p_callback;
+    soft_limit_armed = committed_bytes.load(std::memory_order_relaxed) < soft_limit;
+}
+
+void MemPool::set_hard_limit(size_t p_limit_bytes) {
+    std::lock_guard<std::mutex> lock(central_lock);
+
+    hard_limit = p_limit_bytes;
+    if (p_limit_bytes == 0 || committed_bytes.load(std::memory_order_relaxed) < p_limit_bytes) {
+        hard_limit_reached = false;
+    }
 }
 
-MemBlock* MemPool::find_valid_inactive_block(size_t p_min_block_size) {
-    MemBlock* valid_block = nullptr;
+bool MemPool::new_page(size_t p_class_index) {
+    size_t block_size = get_size_class_block_size(p_class_index);
+    size_t num_blocks = std::max(static_cast<size_t>(1), page_size / block_size);
+
+    // Headers and bytes are carved separately so the objects themselves stay packed.
+    auto headers = static_cast<MemBlock*>(arena.allocate(num_blocks * sizeof(MemBlock), alignof(MemBlock)));
+    // Runs of at least an OS page start on one, so trim() can give all of it back.
+    size_t page_alignment = num_blocks * block_size >= SYMPL_MEM_ARENA_PAGE_SIZE ? SYMPL_MEM_ARENA_PAGE_SIZE : SYMPL_MEM_POOL_MIN_BLOCK_SIZE;
+    auto page = static_cast<StrPtr>(arena.allocate(num_blocks * block_size, page_alignment));
+    if (!headers || !page) {
+        return false;
+    }
 
-    for (const auto& block : blocks) {
-        if (block->active || block->block_size < p_min_block_size) {
+    MemPoolPage pool_page;
+    pool_page.bytes = page;
+    pool_page.size = num_blocks * block_size;
+    auto page_index = static_cast<unsigned int>(pages.size());
+    pages.emplace_back(pool_page);
+
+    // Push in reverse so blocks come back out in address order.
+    for (size_t i = num_blocks; i > 0; --i) {
+        auto block = new(&headers[i - 1]) MemBlock();
+        block->assign(page + (i - 1) * block_size, block_size);
+        block->pool = this;
+        block->page_index = page_index;
+
+        block->block_index = blocks.add(block, static_cast<unsigned char>(p_class_index));
+        if (block->block_index == static_cast<size_t>(-1)) {
+            return false;
+        }
+        push_central(block);
+        pages[page_index].num_blocks++;
+        total_blocks.store(total_blocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total_block_bytes.store(total_block_bytes.load(std::memory_order_relaxed) + block_size, std::memory_order_relaxed);
+    }
+
+    return true;
+}
+
+void MemPool::push_central(MemBlock* p_block) {
+    size_classes[blocks.get_size_class(p_block->block_index)].push(p_block);
+
+    pages[p_block->page_index].central_free++;
+    central_free_bytes += p_block->block_size;
+}
+
+MemBlock* MemPool::pop_central(size_t p_class_index) {
+    MemBlock* block = size_classes[p_class_index].pop();
+    if (!block) {
+        return nullptr;
+    }
+
+    MemPoolPage& page = pages[block->page_index];
+    page.central_free--;
+    central_free_bytes -= block->block_size;
+
+    // The OS hands the page back zeroed on first touch.
+    if (page.purged) {
+        page.purged = false;
+        purged_bytes -= page.size;
+    }
+    return block;
+}
+
+size_t MemPool::trim(size_t p_keep_free_bytes) {
+    std::lock_guard<std::mutex> lock(central_lock);
+    return trim_locked(p_keep_free_bytes);
+}
+
+size_t MemPool::trim_locked(size_t p_keep_free_bytes) {
+    size_t released = 0;
+
+    // Newest pages first, they are the last ones the free lists hand out again.
+    for (size_t i = pages.size(); i > 0; --i) {
+        if (central_free_bytes - purged_bytes <= p_keep_free_bytes) {
+            break;
+        }
+
+        MemPoolPage& page = pages[i - 1];
+        if (page.purged || page.central_free < page.num_blocks) {
             continue;
         }
 
-        if (!valid_block || valid_block->block_size > block->block_size) {
-            valid_block = block;
+        released += MemArena::purge_memory(page.bytes, page.size);
+        page.purged = true;
+        purged_bytes += page.size;
+    }
+
+    return released;
+}
+
+void MemPool::set_trim_policy(size_t p_high_watermark_bytes, size_t p_low_watermark_bytes) {
+    std::lock_guard<std::mutex> lock(central_lock);
+
+    trim_high_watermark = p_high_watermark_bytes;
+    trim_low_watermark = std::min(p_low_watermark_bytes, p_high_watermark_bytes);
+}
+
+size_t MemPool::get_free_resident_bytes() const {
+    std::lock_guard<std::mutex> lock(central_lock);
+    return central_free_bytes - purged_bytes;
+}
+
+size_t MemPool::get_metadata_bytes() const {
+    std::lock_guard<std::mutex> lock(central_lock);
+    return blocks.size() * sizeof(MemBlock) + blocks.get_mapped_bytes();
+}
+
+size_t MemPool::get_purged_bytes() const {
+    std::lock_guard<std::mutex> lock(central_lock);
+    return purged_bytes;
+}
+
+long long MemPool::sum_live_count(size_t p_class_index) const {
+    long long live_count = size_classes[p_class_index].live_count.load(std::memory_order_relaxed);
+    for (const auto& cache : thread_caches) {
+        live_count += cache->size_classes[p_class_index].live_count.load(std::memory_order_relaxed);
+    }
+    return live_count;
+}
+
+long long MemPool::sum_peak_count(size_t p_class_index) const {
+    long long live_count = sum_live_count(p_class_index);
+    long long peak_count = std::max(size_classes[p_class_index].peak_count.load(std::memory_order_relaxed), live_count);
+    // A thread at its own peak, with the rest of the pool at its current count.
+    for (const auto& cache : thread_caches) {
+        const MemSizeClass& cache_class = cache->size_classes[p_class_index];
+        long long others = live_count - cache_class.live_count.load(std::memory_order_relaxed);
+        peak_count = std::max(peak_count, cache_class.peak_count.load(std::memory_order_relaxed) + others);
+    }
+    return peak_count;
+}
+
+void MemPool::fold_peak_counts() {
+    for (size_t i = 0; i < SYMPL_MEM_POOL_MAX_SIZE_CLASSES; ++i) {
+        size_classes[i].peak_count.store(sum_peak_count(i), std::memory_order_relaxed);
+    }
+}
+
+size_t MemPool::register_slab_class(const ObjectRefInfo* p_type_info, size_t p_object_size) {
+    SlabRegistry& registry = get_slab_registry();
+    std::lock_guard<std::mutex> lock(registry.lock);
+
+    int class_index = p_type_info->get_slab_class_index();
+    if (class_index >= 0) {
+        return static_cast<size_t>(class_index);
+    }
+
+    if (registry.next_class_index < SYMPL_MEM_POOL_MAX_SIZE_CLASSES) {
+        // Round up so every object in the slab stays 16-byte aligned.
+        size_t block_size = (p_object_size + SYMPL_MEM_POOL_MIN_BLOCK_SIZE - 1) & ~static_cast<size_t>(SYMPL_MEM_POOL_MIN_BLOCK_SIZE - 1);
+        class_index = static_cast<int>(registry.next_class_index++);
+        registry.block_sizes[class_index] = block_size;
+        registry.type_infos[class_index] = p_type_info;
+    } else {
+        // Out of slab classes, share the power-of-two class instead.
+        class_index = static_cast<int>(get_size_class_index(p_object_size));
+    }
+
+    p_type_info->set_slab_class_index(class_index);
+    return static_cast<size_t>(class_index);
+}
+
+size_t MemPool::get_slab_block_size(size_t p_class_index) {
+    return get_slab_registry().block_sizes[p_class_index];
+}
+
+MemThreadCache* MemPool::get_thread_cache() {
+    if (thread_last_pool_uid == pool_uid) {
+        return thread_last_cache;
+    }
+
+    ThreadCacheList& cache_list = thread_cache_list;
+
+    MemThreadCache* cache = nullptr;
+    for (const auto& entry : cache_list.caches) {
+        if (entry.first == pool_uid) {
+            cache = entry.second;
+            break;
         }
     }
 
-    return valid_block;
+    if (!cache) {
+        cache = new MemThreadCache(this);
+        {
+            std::lock_guard<std::mutex> lock(central_lock);
+            thread_caches.emplace_back(cache);
+        }
+
+        // Forget caches of pools that have been destroyed since, as short-lived pools come and go.
+        {
+            std::lock_guard<std::mutex> lock(get_pool_registry_lock());
+            auto& registry = get_pool_registry();
+            cache_list.caches.erase(std::remove_if(cache_list.caches.begin(), cache_list.caches.end(),
+                [&registry](const std::pair<unsigned long long, MemThreadCache*>& entry) {
+                    return registry.find(entry.first) == registry.end();
+                }), cache_list.caches.end());
+        }
+        cache_list.caches.emplace_back(pool_uid, cache);
+    }
+
+    thread_last_pool_uid = pool_uid;
+    thread_last_cache = cache;
+    return cache;
 }
 
-size_t MemPool::get_mem_usage() const {
-    size_t result = 0;
-    for (const auto& block : blocks) {
-        if (block->active) {
-            result += block->block_size;
+void MemPool::refill_thread_cache(MemThreadCache* p_cache, size_t p_class_index) {
+    MemBudgetCallback callback;
+    size_t callback_committed_bytes = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(central_lock);
+
+        MemSizeClass& central_class = size_classes[p_class_index];
+        MemSizeClass& cache_class = p_cache->size_classes[p_class_index];
+
+        if (cache_class.batch_size == 0) {
+            cache_class.batch_size = get_cache_batch_size(p_class_index);
+        }
+
+        // Only hand out what still fits under the hard limit.
+        size_t block_size = get_size_class_block_size(p_class_index);
+        size_t committed = committed_bytes.load(std::memory_order_relaxed);
+        size_t count = cache_class.batch_size;
+        size_t limit = hard_limit.load(std::memory_order_relaxed);
+        if (limit > 0) {
+            size_t available = committed < limit ? (limit - committed) / block_size : 0;
+            if (available == 0) {
+                hard_limit_reached = true;
+                return;
+            }
+            count = std::min(count, available);
+        }
+
+        size_t refilled = 0;
+        for (; refilled < count; ++refilled) {
+            MemBlock* block = pop_central(p_class_index);
+            if (!block && new_page(p_class_index)) {
+                block = pop_central(p_class_index);
+            }
+            if (!block) {
+                break;
+            }
+            cache_class.push(block);
+        }
+
+        committed += refilled * block_size;
+        committed_bytes.store(committed, std::memory_order_relaxed);
+
+        // Sample the peak while we hold the lock anyway.
+        central_class.raise_peak(sum_live_count(p_class_index));
+
+        if (soft_limit > 0 && soft_limit_armed && committed >= soft_limit) {
+            soft_limit_armed = false;
+            callback = soft_limit_callback;
+            callback_committed_bytes = committed;
         }
     }
-    return result;
+
+    // Fire outside the lock so the host may allocate or free from the callback.
+    if (callback) {
+        callback(this, callback_committed_bytes, soft_limit);
+    }
 }
 
-size_t MemPool::get_used_blocks() const {
-    size_t result = 0;
-    for (const auto& block : blocks) {
-        if (block->active) {
-            result++;
+void MemPool::flush_thread_cache(MemThreadCache* p_cache, size_t p_class_index, size_t p_count) {
+    std::lock_guard<std::mutex> lock(central_lock);
+
+    MemSizeClass& cache_class = p_cache->size_classes[p_class_index];
+
+    size_t flushed = 0;
+    for (; flushed < p_count; ++flushed) {
+        MemBlock* block = cache_class.pop();
+        if (!block) {
+            break;
         }
+        push_central(block);
+    }
+
+    if (flushed == 0) {
+        return;
+    }
+
+    if (trim_high_watermark > 0 && central_free_bytes - purged_bytes > trim_high_watermark) {
+        trim_locked(trim_low_watermark);
+    }
+
+    uncommit_locked(flushed * get_size_class_block_size(p_class_index));
+}
+
+void MemPool::release_thread_cache(MemThreadCache* p_cache) {
+    for (size_t i = 0; i < SYMPL_MEM_POOL_MAX_SIZE_CLASSES; ++i) {
+        flush_thread_cache(p_cache, i, p_cache->size_classes[i].free_count);
+    }
+
+    std::lock_guard<std::mutex> lock(central_lock);
+    fold_peak_counts();
+
+    // Keep the live counts of the exiting thread.
+    for (size_t i = 0; i < SYMPL_MEM_POOL_MAX_SIZE_CLASSES; ++i) {
+        size_classes[i].add_live(p_cache->size_classes[i].live_count.load(std::memory_order_relaxed));
+    }
+    retired_live_blocks += p_cache->live_blocks.load(std::memory_order_relaxed);
+    retired_live_bytes += p_cache->live_bytes.load(std::memory_order_relaxed);
+
+    thread_caches.erase(std::remove(thread_caches.begin(), thread_caches.end(), p_cache), thread_caches.end());
+    delete p_cache;
+}
+
+size_t MemPool::get_mem_usage() const {
+    std::lock_guard<std::mutex> lock(central_lock);
+
+    long long result = retired_live_bytes + static_cast<long long>(large_objects.get_mapped_bytes());
+    for (const auto& cache : thread_caches) {
+        result += cache->live_bytes.load(std::memory_order_relaxed);
+    }
+    return result > 0 ? static_cast<size_t>(result) : 0;
+}
+
+size_t MemPool::get_used_blocks() const {
+    std::lock_guard<std::mutex> lock(central_lock);
+
+    long long result = retired_live_blocks + static_cast<long long>(large_objects.get_num_blocks());
+    for (const auto& cache : thread_caches) {
+        result += cache->live_blocks.load(std::memory_order_relaxed);
     }
-    return result;
+    return result > 0 ? static_cast<size_t>(result) : 0;
 }
 
 size_t MemPool::get_unused_blocks() const {
-    size_t result = 0;
-    for (const auto& block : blocks) {
-        if (!block->active) {
-            result++;
-        }
+    size_t used_blocks = get_used_blocks();
+    {
+        // Large blocks are never kept around unused.
+        std::lock_guard<std::mutex> lock(central_lock);
+        used_blocks -= std::min(used_blocks, large_objects.get_num_blocks());
     }
-    return result;
+    size_t num_blocks = total_blocks.load(std::memory_order_relaxed);
+    return num_blocks > used_blocks ? num_blocks - used_blocks : 0;
 }
 
 void MemPool::get_used_block_object_names(std::vector<std::string>& output) {
-    std::unordered_map<std::string, int> block_map_count;
+    // A heap walk rather than the slab counters, so types sharing a size class show up too.
+    std::vector<size_t> counts;
+    count_live_types(counts);
 
-    for (const auto& block : blocks) {
-        if (!block->active) {
-            continue;
+    std::vector<std::pair<size_t, unsigned short>> live_types;
+    for (size_t type_id = 0; type_id < counts.size(); ++type_id) {
+        if (counts[type_id] > 0) {
+            live_types.emplace_back(counts[type_id], static_cast<unsigned short>(type_id));
         }
+    }
+    std::sort(live_types.begin(), live_types.end(), [](const std::pair<size_t, unsigned short>& a, const std::pair<size_t, unsigned short>& b) {
+        return a.first > b.first;
+    });
+
+    for (const auto& live_type : live_types) {
+        const ObjectRefInfo* type_info = ObjectRefInfo::find_type_info(live_type.second);
+        output.emplace_back((type_info ? type_info->get_type_name() : std::string("<untyped>")) + ": " + std::to_string(live_type.first));
+    }
+}
+
+void MemPool::get_type_usage(std::vector<MemTypeUsage>& output) const {
+    SlabRegistry& registry = get_slab_registry();
+    std::lock_guard<std::mutex> lock(central_lock);
+
+    size_t num_classes = 0;
+    {
+        std::lock_guard<std::mutex> registry_lock(registry.lock);
+        num_classes = registry.next_class_index;
+    }
 
-        auto entry = block_map_count.find(block->get_identifier());
-        if (entry == block_map_count.end()) {
-            block_map_count[block->get_identifier()] = 1;
-        } else {
-            entry->second++;
+    for (size_t i = SYMPL_MEM_POOL_NUM_SIZE_CLASSES; i < num_classes; ++i) {
+        long long live_count = sum_live_count(i);
+        long long peak_count = sum_peak_count(i);
+        if (live_count <= 0 && peak_count <= 0) {
+            continue;
         }
+
+        MemTypeUsage usage;
+        usage.type_info = registry.type_infos[i];
+        usage.live_count = live_count > 0 ? static_cast<size_t>(live_count) : 0;
+        usage.live_bytes = usage.live_count * registry.block_sizes[i];
+        usage.peak_count = static_cast<size_t>(peak_count);
+        output.emplace_back(usage);
     }
 
-    for (const auto& entry : block_map_count) {
-        //output.emplace_back(fmt::format("{0}: {1}", entry.first, entry.second));
+    std::sort(output.begin(), output.end(), [](const MemTypeUsage& a, const MemTypeUsage& b) {
+        return a.live_bytes > b.live_bytes;
+    });
+}
+
+long long MemPool::get_type_live_count(const ObjectRefInfo* p_type_info) const {
+    int class_index = p_type_info->get_slab_class_index();
+    if (class_index < SYMPL_MEM_POOL_NUM_SIZE_CLASSES) {
+        return 0;
     }
+
+    std::lock_guard<std::mutex> lock(central_lock);
+    return sum_live_count(static_cast<size_t>(class_index));
+}
+
+long long MemPool::get_type_peak_count(const ObjectRefInfo* p_type_info) const {
+    int class_index = p_type_info->get_slab_class_index();
+    if (class_index < SYMPL_MEM_POOL_NUM_SIZE_CLASSES) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(central_lock);
+    return sum_peak_count(static_cast<size_t>(class_index));
 }
 
 SymplNamespaceEnd
@@ -5,60 +5,522 @@
 //
 #pragma once
 #include <sympl/sympl_pch.hpp>
+#include <sympl/memory/mem_size_class.hpp>
+#include <sympl/memory/object_ref_info.hpp>
+#include <sympl/memory/mem_arena.hpp>
+#include <sympl/memory/mem_block_table.hpp>
+#include <sympl/memory/mem_pool_config.hpp>
+#include <sympl/memory/mem_large_object_space.hpp>
 
 SymplNamespaceStart
 
 class MemBlock;
+class MemPool;
+class MemThreadCache;
+
+/**
+ * Live usage of a single type in a pool.
+ */
+struct SYMPL_API MemTypeUsage
+{
+    // Type the usage is for.
+    const ObjectRefInfo* type_info = nullptr;
+
+    // Live objects of the type.
+    size_t live_count = 0;
+
+    // Bytes held by the live objects, in whole blocks.
+    size_t live_bytes = 0;
+
+    // Highest live count seen, exact while one thread allocates the type.
+    size_t peak_count = 0;
+};
+
+/**
+ * Run of block bytes carved for one size class at once.
+ */
+struct SYMPL_API MemPoolPage
+{
+    // Start of the block bytes.
+    StrPtr bytes = nullptr;
+
+    // Size of the run.
+    size_t size = 0;
+
+    // Blocks carved from the run.
+    unsigned int num_blocks = 0;
+
+    // Blocks of the run sitting in the central free list.
+    unsigned int central_free = 0;
+
+    // Whether the run was given back to the OS since it was last used.
+    bool purged = false;
+};
+
+// Called when a pool's committed bytes cross its soft limit.
+typedef std::function<void(MemPool* p_pool, size_t p_committed_bytes, size_t p_soft_limit)> MemBudgetCallback;
+
+// Bytes moved between a thread cache and the central pool per batch.
+#define SYMPL_MEM_POOL_CACHE_BATCH_BYTES (64 * 1024)
+// Max blocks moved between a thread cache and the central pool per batch.
+#define SYMPL_MEM_POOL_CACHE_MAX_BATCH 64
 
 class SYMPL_API MemPool
 {
+    friend class MemThreadCache;
+    friend class MemPoolScope;
+
 private:
+    // Unique id of the pool, used to find the thread caches.
+    unsigned long long pool_uid = 0;
+
+    // Id of the pool's current set of blocks, changed by clear() so handles
+    // taken before it, or into another pool, never resolve here.
+    std::atomic<unsigned int> heap_id{0};
+
+#ifdef SYMPL_DEBUG
+    // Weak pointers into the pool, which must all be gone before the pool is.
+    std::atomic<long long> num_weak_refs{0};
+#endif
+
     // Default size of a block.
     size_t default_block_size = 1024;
 
-    // Current blocks in use.
-    std::vector<class MemBlock*> blocks;
+    // Bytes carved into blocks at once when a size class runs dry.
+    size_t page_size = 64 * 1024;
+
+    // Block size past which blocks come from the large object space.
+    size_t large_object_threshold = SYMPL_MEM_POOL_LARGE_OBJECT_THRESHOLD;
+
+    // How block memory is filled on allocation and free.
+    MemFillMode fill_mode = MemFillMode::None;
+
+    // Every block carved so far, by block index.
+    MemBlockTable blocks;
+
+    // Central segregated free lists, one per size class. Classes past
+    // SYMPL_MEM_POOL_NUM_SIZE_CLASSES are per-type slabs.
+    MemSizeClass size_classes[SYMPL_MEM_POOL_MAX_SIZE_CLASSES];
+
+    // Arena the block headers and block bytes are carved from.
+    MemArena arena;
+
+    // Blocks and buffers past the large object threshold, mapped one by one.
+    MemLargeObjectSpace large_objects;
+
+    // Every page carved so far, by page index.
+    std::vector<MemPoolPage> pages;
+
+    // Bytes of blocks in the central free lists, and how many of those were given back to the OS.
+    size_t central_free_bytes = 0;
+    size_t purged_bytes = 0;
+
+    // Resident free bytes that start an automatic trim, 0 for none, and what the trim leaves.
+    size_t trim_high_watermark = 0;
+    size_t trim_low_watermark = 0;
+
+    // Bytes in blocks handed out to thread caches, live or cached. Written under the central lock.
+    std::atomic<size_t> committed_bytes{0};
+
+    // Committed bytes past which the soft limit callback fires, 0 for no limit.
+    size_t soft_limit = 0;
+
+    // Committed bytes past which allocations fail, 0 for no limit.
+    std::atomic<size_t> hard_limit{0};
+
+    // Whether the soft limit callback fires the next time the limit is crossed.
+    bool soft_limit_armed = true;
+
+    // Set when an allocation failed on the hard limit, until usage drops back under it.
+    std::atomic<bool> hard_limit_reached{false};
+
+    // Called when the soft limit is crossed.
+    MemBudgetCallback soft_limit_callback;
+
+    // Blocks and block bytes carved so far.
+    std::atomic<size_t> total_blocks{0};
+    std::atomic<size_t> total_block_bytes{0};
+
+    // Live blocks and bytes left behind by threads that have exited.
+    long long retired_live_blocks = 0;
+    long long retired_live_bytes = 0;
+
+    // Thread caches created for this pool.
+    std::vector<MemThreadCache*> thread_caches;
+
+    // Guards the blocks, the central free lists and the thread cache list.
+    mutable std::mutex central_lock;
+
+    // Set while the pool runs __destruct hooks before dropping every block,
+    // so objects the hooks release only have their blocks marked free.
+    bool releasing = false;
+
+    // Pool new objects go to on this thread, nullptr for the shared instance.
+    static thread_local MemPool* current_pool;
 
     /**
-     * Constructor.
+     * Marks the instance config as used and returns it.
+     * @return
+     */
+    static const MemPoolConfig& lock_instance_config();
+
+    /**
+     * Carves a page of blocks for a size class into the central free list.
+     * Expects the central lock to be held.
+     * @param p_class_index
+     * @return
+     */
+    bool new_page(size_t p_class_index);
+
+    /**
+     * Pops a block from the calling thread's cache and prepares it for use.
+     * @param p_class_index
+     * @param p_block_size
+     * @param p_type_info Type recorded for heap walks, nullptr if unknown.
+     * @return
+     */
+    MemBlock* take_block(size_t p_class_index, size_t p_block_size, const ObjectRefInfo* p_type_info);
+
+    /**
+     * Maps a block of its own for a size past the large object threshold.
+     * @param p_block_size
+     * @param p_type_info Type recorded for heap walks, nullptr if unknown.
+     * @return
+     */
+    MemBlock* create_large_block(size_t p_block_size, const ObjectRefInfo* p_type_info);
+
+    /**
+     * Unmaps a large block once its object is destroyed.
+     * @param p_block
+     */
+    void free_large_block(MemBlock* p_block);
+
+    /**
+     * Counts bytes against the budgets, all or nothing. Expects the central lock to be held.
+     * @param p_bytes
+     * @param r_callback Set to the soft limit callback when this crosses the soft limit.
+     * @param r_committed_bytes Committed bytes to pass to the callback.
+     * @return false if the bytes would pass the hard limit.
+     */
+    bool commit_locked(size_t p_bytes, MemBudgetCallback& r_callback, size_t& r_committed_bytes);
+
+    /**
+     * Stops counting bytes against the budgets. Expects the central lock to be held.
+     * @param p_bytes
+     */
+    void uncommit_locked(size_t p_bytes);
+
+    /**
+     * Pushes a block onto a central free list. Expects the central lock to be held.
+     * @param p_block
+     */
+    void push_central(MemBlock* p_block);
+
+    /**
+     * Pops a block from a central free list. Expects the central lock to be held.
+     * @param p_class_index
+     * @return
+     */
+    MemBlock* pop_central(size_t p_class_index);
+
+    /**
+     * Runs the __destruct hook of every live object that has one, so memory the
+     * objects hold outside the pool is given back. Nothing else is destructed.
+     * Expects the central lock not to be held, the hooks may free buffers.
+     * @param p_include_static Whether immortal objects are destructed too.
+     */
+    void destruct_objects(bool p_include_static);
+
+    /**
+     * Gives fully free pages back to the OS. Expects the central lock to be held.
+     * @param p_keep_free_bytes
+     * @return
+     */
+    size_t trim_locked(size_t p_keep_free_bytes);
+
+    /**
+     * Returns the live count of a size class across all thread caches.
+     * Expects the central lock to be held.
+     * @param p_class_index
+     * @return
+     */
+    long long sum_live_count(size_t p_class_index) const;
+
+    /**
+     * Returns the peak live count of a size class. Each thread cache's own peak
+     * is combined with the current count of the rest of the pool, so the peak
+     * is exact while one thread allocates from the class and approximate when
+     * several do. Expects the central lock to be held.
+     * @param p_class_index
+     * @return
+     */
+    long long sum_peak_count(size_t p_class_index) const;
+
+    /**
+     * Folds the thread cache peaks into the central peak of every size class,
+     * before the caches drop their counts. Expects the central lock to be held.
+     */
+    void fold_peak_counts();
+
+    /**
+     * Assigns a slab size class to a type.
+     * @param p_type_info
+     * @param p_object_size
+     * @return
      */
-    MemPool();
+    static size_t register_slab_class(const ObjectRefInfo* p_type_info, size_t p_object_size);
 
     /**
-     * Attempts to find a valid inactive block.
-     * @param p_min_block_size
+     * Returns the block size of a per-type slab class.
+     * @param p_class_index
      * @return
      */
-    class MemBlock* find_valid_inactive_block(size_t p_min_block_size = 0);
+    static size_t get_slab_block_size(size_t p_class_index);
+
+    /**
+     * Returns the calling thread's cache for this pool.
+     * @return
+     */
+    MemThreadCache* get_thread_cache();
+
+    /**
+     * Moves a batch of free blocks from the central pool into a thread cache.
+     * @param p_cache
+     * @param p_class_index
+     */
+    void refill_thread_cache(MemThreadCache* p_cache, size_t p_class_index);
+
+    /**
+     * Moves free blocks from a thread cache back into the central pool.
+     * @param p_cache
+     * @param p_class_index
+     * @param p_count
+     */
+    void flush_thread_cache(MemThreadCache* p_cache, size_t p_class_index, size_t p_count);
 
 public:
+    //! Constructor.
+    //! \param p_config
+    explicit MemPool(const MemPoolConfig& p_config = MemPoolConfig());
+
+    //! Destructor. Releases every block in the pool, see clear().
+    ~MemPool();
+
+    MemPool(const MemPool&) = delete;
+    MemPool& operator=(const MemPool&) = delete;
+
+    //! Sets the config the shared instance is created with.
+    //! Must be called before the first call to instance().
+    //! \param p_config
+    //! \return false if the instance already exists.
+    static bool configure(const MemPoolConfig& p_config);
+
+    //! Flushes and destroys a thread cache, called when its thread exits.
+    //! \param p_cache
+    void release_thread_cache(MemThreadCache* p_cache);
+
+    //! Sets how block memory is filled on allocation and free.
+    //! Blocks are handed out uninitialized unless zero or poison mode is enabled.
+    //! \param p_fill_mode
+    inline void set_fill_mode(MemFillMode p_fill_mode) { fill_mode = p_fill_mode; }
+
+    //! Returns how block memory is filled on allocation and free.
+    //! \return
+    inline MemFillMode get_fill_mode() const { return fill_mode; }
+
+    //! Sets whether arena chunks mapped from now on use huge pages.
+    //! \param p_use_huge_pages
+    void set_use_huge_pages(bool p_use_huge_pages);
+
+    //! Returns the bytes mapped from the OS for the pool.
+    //! \return
+    size_t get_reserved_bytes() const;
+
     //! Allocates a certain number of new blocks.
     //! \param num_blocks
     void alloc_blocks(const int num_blocks);
 
     //! Creates a new block of a given size.
     //! \param block_size
-    //! \return 
+    //! \return
     MemBlock* create_block(const size_t block_size);
 
+    //! Creates a new block from the slab dedicated to a type.
+    //! \param block_size
+    //! \param p_type_info
+    //! \return
+    MemBlock* create_block(const size_t block_size, const ObjectRefInfo* p_type_info);
+
     //! Frees a block from at a given index.
     //! \param p_block
     void free_block(const class MemBlock* p_block);
 
-    //! Frees all blocks.
+    //! Maps a raw buffer of its own from the large object space. The memory reads as zero.
+    //! Meant for buffers past the large object threshold, smaller ones are better off with malloc.
+    //! \param p_size
+    //! \return nullptr past the hard limit or when the OS is out of memory.
+    StrPtr alloc_large_buffer(size_t p_size);
+
+    //! Unmaps a buffer returned by alloc_large_buffer.
+    //! \param p_buffer
+    void free_large_buffer(StrPtr p_buffer);
+
+    //! Returns whether a block or buffer of a given size comes from the large object space.
+    //! \param p_size
+    //! \return
+    inline bool is_large_size(size_t p_size) const { return p_size > large_object_threshold; }
+
+    //! Returns the size past which blocks and buffers come from the large object space.
+    //! \return
+    inline size_t get_large_object_threshold() const { return large_object_threshold; }
+
+    //! Returns the number of live large blocks and buffers.
+    //! \return
+    size_t get_large_object_count() const;
+
+    //! Returns the bytes mapped for live large blocks and buffers.
+    //! \return
+    size_t get_large_object_bytes() const;
+
+    //! Returns the id handles into the pool's current blocks carry.
+    //! \return
+    inline unsigned int get_heap_id() const { return heap_id.load(std::memory_order_acquire); }
+
+    //! Counts a weak pointer into the pool. Only debug builds keep the count.
+    inline void add_weak_ref()
+    {
+#ifdef SYMPL_DEBUG
+        num_weak_refs.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    //! Uncounts a weak pointer into the pool.
+    inline void release_weak_ref()
+    {
+#ifdef SYMPL_DEBUG
+        num_weak_refs.fetch_sub(1, std::memory_order_relaxed);
+#endif
+    }
+
+    //! Returns the live block a handle refers to, or nullptr once the object is gone.
+    //! Safe to call from any thread while the pool exists.
+    //! \param p_handle
+    //! \return
+    MemBlock* resolve(MemHandle p_handle) const;
+
+    //! Returns whether the object a handle refers to is still alive.
+    //! \param p_handle
+    //! \return
+    inline bool is_alive(MemHandle p_handle) const { return resolve(p_handle) != nullptr; }
+
+    //! Marks a live block as holding an object with a __destruct hook, run when the heap is dropped.
+    //! \param p_block
+    inline void set_destruct(MemBlock* p_block) { blocks.set_destruct(p_block->block_index); }
+
+    //! Sets whether a live block holds an object that is never freed.
+    //! Objects are made immortal with ManagedObject::set_immortal, which calls this.
+    //! \param p_block
+    //! \param p_static
+    void set_static(MemBlock* p_block, bool p_static);
+
+    //! Walks the heap and counts the blocks holding an object.
+    //! Only the flag bytes are read, one per block and eight at a time, so about 64 KB per 64K blocks.
+    //! \return
+    size_t count_live_blocks() const;
+
+    //! Walks the heap and counts the blocks holding a static object.
+    //! \return
+    size_t count_static_blocks() const;
+
+    //! Walks the heap and counts the live objects of every type.
+    //! Only the flag bytes and the type id array are read, no block headers.
+    //! Blocks allocated without a type are counted under id 0.
+    //! \param r_counts Indexed by type id, grown to fit every id seen.
+    //! \return Number of live blocks.
+    size_t count_live_types(std::vector<size_t>& r_counts) const;
+
+    //! Calls a function with every live block. Other threads must not be using the pool.
+    //! \tparam F
+    //! \param p_function
+    template<class F>
+    void for_each_live_block(F p_function) const
+    {
+        std::lock_guard<std::mutex> lock(central_lock);
+        blocks.for_each_live([this, &p_function](size_t p_index) {
+            p_function(blocks.get(p_index));
+        });
+    }
+
+    //! Frees all blocks except the static ones, which hold immortal objects.
+    //! Objects are not destructed, only their __destruct hooks run.
+    //! Other threads must not be using the pool.
     void free_all_blocks();
 
-    //! Free all blocks in the pool.
+    //! Drops every block in the pool at once, in time linear in the arena chunks
+    //! rather than the objects. Objects are not destructed, only their __destruct
+    //! hooks run, so references into other pools they hold are never released.
+    //! Other threads must not be using the pool.
     void clear();
 
-    //! Retrieves the total memory usage.
+    //! Gives the memory of pages whose blocks are all free back to the OS.
+    //! The pages stay mapped, so blocks and handles into them remain valid.
+    //! Blocks cached by threads are not counted as free.
+    //! \param p_keep_free_bytes Free bytes to leave resident.
+    //! \return Bytes given back.
+    size_t trim(size_t p_keep_free_bytes = 0);
+
+    //! Sets when the pool trims by itself. Once the resident free bytes pass
+    //! the high watermark, pages are given back until only the low watermark
+    //! remains. The gap keeps steady churn from trimming over and over.
+    //! \param p_high_watermark_bytes 0 to only trim on request.
+    //! \param p_low_watermark_bytes
+    void set_trim_policy(size_t p_high_watermark_bytes, size_t p_low_watermark_bytes);
+
+    //! Returns the bytes of free blocks in the central lists that are still resident.
+    //! \return
+    size_t get_free_resident_bytes() const;
+
+    //! Returns the bytes of free pages given back to the OS.
+    //! \return
+    size_t get_purged_bytes() const;
+
+    //! Returns the bytes of block headers and block table segments. trim() never
+    //! gives these back: free lists link through the headers, and their generations
+    //! must survive for stale handles to be caught, so they stay resident until clear().
+    //! \return
+    size_t get_metadata_bytes() const;
+
+    //! Retrieves the total memory usage, in bytes of every block carved.
     //! \return
     size_t total_mem_usage() const;
 
-    //! Check if we're at the max mem usage.
+    //! Check if we're at the max mem usage. Cheap enough to call every loop iteration.
     //! \return
     bool is_max_mem_usage() const;
 
+    //! Sets the soft byte budget and the callback fired when it is crossed.
+    //! The callback runs on the allocating thread, outside the pool lock.
+    //! \param p_limit_bytes
+    //! \param p_callback
+    void set_soft_limit(size_t p_limit_bytes, MemBudgetCallback p_callback);
+
+    //! Sets the hard byte budget. Allocations past it return nullptr.
+    //! \param p_limit_bytes
+    void set_hard_limit(size_t p_limit_bytes);
+
+    //! Returns the soft byte budget, 0 for none.
+    //! \return
+    inline size_t get_soft_limit() const { return soft_limit; }
+
+    //! Returns the hard byte budget, 0 for none.
+    //! \return
+    inline size_t get_hard_limit() const { return hard_limit.load(std::memory_order_relaxed); }
+
+    //! Returns the bytes counted against the budgets: every block handed
+    //! out to a thread, including the few a thread keeps cached.
+    //! \return
+    inline size_t get_committed_bytes() const { return committed_bytes.load(std::memory_order_relaxed); }
+
     //! Returns the current memory usage.
     //! \return
     size_t get_mem_usage() const;
@@ -71,17 +533,129 @@ public:
     //! \return
     size_t get_unused_blocks() const;
 
-    //! Returns the object names that are being used.
+    //! Returns the object names that are being used, with their live counts.
     //! \param output
     void get_used_block_object_names(std::vector<std::string>& output);
 
+    //! Returns the live count, bytes and peak of every type allocated from its own slab,
+    //! largest live bytes first.
+    //! \param output
+    void get_type_usage(std::vector<MemTypeUsage>& output) const;
+
+    //! Returns the number of live objects of a type allocated through its slab.
+    //! \param p_type_info
+    //! \return
+    long long get_type_live_count(const ObjectRefInfo* p_type_info) const;
+
+    //! Returns the highest live count of a type. Exact while one thread allocates the type.
+    //! \param p_type_info
+    //! \return
+    long long get_type_peak_count(const ObjectRefInfo* p_type_info) const;
+
+    //! Returns the size class a block size falls into.
+    //! \param block_size
+    //! \return
+    static inline size_t get_size_class_index(size_t block_size)
+    {
+        if (block_size <= SYMPL_MEM_POOL_MIN_BLOCK_SIZE) {
+            return 0;
+        }
+
+        // Index of the highest bit of (block_size - 1), offset by log2 of the minimum size.
+#if defined(__GNUC__) || defined(__clang__)
+        size_t high_bit = 63 - static_cast<size_t>(__builtin_clzll(static_cast<unsigned long long>(block_size - 1)));
+#else
+        size_t high_bit = 0;
+        for (size_t value = block_size - 1; value > 1; value >>= 1) {
+            high_bit++;
+        }
+#endif
+        return high_bit + 1 - 4;
+    }
+
+    //! Returns the block size of a size class.
+    //! \param class_index
+    //! \return
+    static inline size_t get_size_class_block_size(size_t class_index)
+    {
+        if (class_index >= SYMPL_MEM_POOL_NUM_SIZE_CLASSES) {
+            return get_slab_block_size(class_index);
+        }
+        return static_cast<size_t>(SYMPL_MEM_POOL_MIN_BLOCK_SIZE) << class_index;
+    }
+
+    //! Returns the size class dedicated to a type, assigning one on first use.
+    //! \param p_type_info
+    //! \param object_size
+    //! \return
+    static inline size_t get_slab_class_index(const ObjectRefInfo* p_type_info, size_t object_size)
+    {
+        int class_index = p_type_info->get_slab_class_index();
+        if (class_index >= 0) {
+            return static_cast<size_t>(class_index);
+        }
+        return register_slab_class(p_type_info, object_size);
+    }
+
+    //! Returns how many blocks of a size class move per refill or flush.
+    //! \param class_index
+    //! \return
+    static inline size_t get_cache_batch_size(size_t class_index)
+    {
+        size_t batch_size = SYMPL_MEM_POOL_CACHE_BATCH_BYTES / get_size_class_block_size(class_index);
+        if (batch_size < 1) {
+            return 1;
+        }
+        if (batch_size > SYMPL_MEM_POOL_CACHE_MAX_BATCH) {
+            return SYMPL_MEM_POOL_CACHE_MAX_BATCH;
+        }
+        return batch_size;
+    }
+
     //! Returns the instance for the pool.
     //! \return
     inline static MemPool* instance()
     {
-        static MemPool pool;
+        static MemPool pool(lock_instance_config());
         return &pool;
     }
+
+    //! Returns the pool new objects go to on the calling thread: the one set by
+    //! the innermost MemPoolScope, or the shared instance.
+    //! \return
+    inline static MemPool* current()
+    {
+        MemPool* pool = current_pool;
+        return pool ? pool : instance();
+    }
+};
+
+/**
+ * Sends the objects created on the calling thread to a pool until the scope
+ * ends. A VM holds one while it runs so everything it allocates lands in its
+ * own heap, and dropping the heap frees it all at once. Objects in one heap
+ * must not hold references into another; copy values across instead.
+ */
+class SYMPL_API MemPoolScope
+{
+private:
+    // Pool that was current before the scope.
+    MemPool* previous_pool = nullptr;
+
+public:
+    /**
+     * Constructor.
+     * @param p_pool
+     */
+    explicit MemPoolScope(MemPool* p_pool) : previous_pool(MemPool::current_pool) { MemPool::current_pool = p_pool; }
+
+    /**
+     * Destructor. Restores the pool that was current before.
+     */
+    ~MemPoolScope() { MemPool::current_pool = previous_pool; }
+
+    MemPoolScope(const MemPoolScope&) = delete;
+    MemPoolScope& operator=(const MemPoolScope&) = delete;
 };
 
 SymplNamespaceEnd
@@ -0,0 +1,25 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#include "mem_pool_config.hpp"
+#include "mem_pool.hpp"
+SymplNamespace
+
+void MemPoolConfig::set_prewarm(size_t p_block_size, size_t p_num_blocks)
+{
+    size_t class_index = MemPool::get_size_class_index(p_block_size);
+    if (class_index < SYMPL_MEM_POOL_NUM_SIZE_CLASSES) {
+        prewarm_blocks[class_index] = p_num_blocks;
+    }
+}
+
+MemPoolConfig MemPoolConfig::minimal()
+{
+    MemPoolConfig config;
+    config.initial_reserve_bytes = 0;
+    config.chunk_size = 256 * 1024;
+    for (auto& num_blocks : config.prewarm_blocks) {
+        num_blocks = 0;
+    }
+    return config;
+}
@@ -0,0 +1,83 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include <sympl/memory/mem_size_class.hpp>
+#include <sympl/memory/mem_arena.hpp>
+#include <sympl/memory/mem_large_object_space.hpp>
+
+SymplNamespaceStart
+
+/**
+ * Warm-up and growth policy for a MemPool.
+ */
+struct SYMPL_API MemPoolConfig
+{
+    // Block size used by MemPool::alloc_blocks.
+    size_t default_block_size = 256;
+
+    // Bytes mapped when the pool is created, 0 to map lazily.
+    size_t initial_reserve_bytes = SYMPL_MEM_ARENA_CHUNK_SIZE;
+
+    // Size of the first arena chunk mapped after the initial reservation.
+    size_t chunk_size = SYMPL_MEM_ARENA_CHUNK_SIZE;
+
+    // Each new arena chunk is this much larger than the previous one.
+    double growth_factor = 2.0;
+
+    // Largest arena chunk the growth factor can reach.
+    size_t max_chunk_size = 64 * 1024 * 1024;
+
+    // Most bytes the pool may map from the OS, 0 for no limit.
+    size_t max_size = 0;
+
+    // Bytes in use past which the soft limit callback fires, 0 for no limit.
+    size_t soft_limit_bytes = 0;
+
+    // Bytes in use past which allocations fail, 0 for no limit.
+    size_t hard_limit_bytes = 0;
+
+    // Bytes carved into blocks at once when a size class runs dry.
+    size_t page_size = 64 * 1024;
+
+    // Block size past which blocks get a mapping of their own, which is unmapped as soon as they are freed.
+    size_t large_object_threshold = SYMPL_MEM_POOL_LARGE_OBJECT_THRESHOLD;
+
+    // Free bytes the pool may keep resident before it gives pages back to the OS, 0 to only trim on request.
+    size_t trim_high_watermark_bytes = 0;
+
+    // Free bytes left resident once an automatic trim runs.
+    size_t trim_low_watermark_bytes = 0;
+
+    // Whether arena chunks use huge pages.
+    bool use_huge_pages = false;
+
+    // How block memory is filled on allocation and free.
+    MemFillMode fill_mode = MemFillMode::None;
+
+    // Blocks carved up front for each power-of-two size class.
+    size_t prewarm_blocks[SYMPL_MEM_POOL_NUM_SIZE_CLASSES] = {};
+
+    /**
+     * Constructor. Warms up 2000 blocks of the default block size.
+     */
+    MemPoolConfig()
+    {
+        set_prewarm(default_block_size, 2000);
+    }
+
+    /**
+     * Sets how many blocks to carve up front for the size class of a block size.
+     * @param p_block_size
+     * @param p_num_blocks
+     */
+    void set_prewarm(size_t p_block_size, size_t p_num_blocks);
+
+    /**
+     * Returns a config that maps and carves nothing until the first allocation.
+     * @return
+     */
+    static MemPoolConfig minimal();
+};
+
+SymplNamespaceEnd
@@ -0,0 +1,94 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#include "mem_release_queue.hpp"
+#include "managed_object.hpp"
+SymplNamespace
+
+thread_local MemReleaseQueue* MemReleaseQueue::active_queue = nullptr;
+
+namespace {
+    // Queue of the calling thread, null once the thread has torn it down.
+    thread_local MemReleaseQueue* thread_queue = nullptr;
+    thread_local bool thread_queue_destroyed = false;
+
+    // Destroys what is still queued and deletes the queue when the thread exits.
+    struct ThreadQueueGuard
+    {
+        ~ThreadQueueGuard()
+        {
+            if (thread_queue) {
+                thread_queue->set_enabled(false);
+            }
+            delete thread_queue;
+            thread_queue = nullptr;
+            thread_queue_destroyed = true;
+        }
+    };
+    thread_local ThreadQueueGuard thread_queue_guard;
+}
+
+MemReleaseQueue* MemReleaseQueue::instance()
+{
+    if (!thread_queue && !thread_queue_destroyed) {
+        thread_queue = new MemReleaseQueue();
+        (void)&thread_queue_guard;
+    }
+    return thread_queue;
+}
+
+void MemReleaseQueue::set_enabled(bool p_enabled)
+{
+    if (p_enabled) {
+        active_queue = this;
+        return;
+    }
+
+    if (active_queue == this) {
+        active_queue = nullptr;
+    }
+    drain();
+}
+
+size_t MemReleaseQueue::drain(long long p_budget_ns)
+{
+    if (draining) {
+        return 0;
+    }
+    draining = true;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    long long elapsed_ns = 0;
+    size_t destroyed = 0;
+
+    // Newest first, so the children a destroyed object just queued are still cache-hot.
+    while (!objects.empty()) {
+        ManagedObject* object = objects.back();
+        objects.pop_back();
+        object->free_object();
+        destroyed++;
+
+        if (p_budget_ns > 0 && destroyed % SYMPL_MEM_RELEASE_CLOCK_STRIDE == 0) {
+            elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+            if (elapsed_ns >= p_budget_ns) {
+                break;
+            }
+        }
+    }
+
+    elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    draining = false;
+    num_drains++;
+    num_destroyed += destroyed;
+    last_drain_ns = elapsed_ns;
+    max_drain_ns = std::max(max_drain_ns, elapsed_ns);
+
+    return destroyed;
+}
+
+void MemReleaseQueue::remove_objects(const MemPool* p_pool)
+{
+    objects.erase(std::remove_if(objects.begin(), objects.end(), [p_pool](ManagedObject* p_object) {
+        return p_object->get_pool() == p_pool;
+    }), objects.end());
+}
@@ -0,0 +1,169 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include <sympl/sympl_pch.hpp>
+
+SymplNamespaceStart
+
+class ManagedObject;
+class MemPool;
+
+// Time a safe point may spend destroying queued objects, in nanoseconds.
+#define SYMPL_MEM_RELEASE_SLICE_BUDGET_NS 500000
+// Objects destroyed between clock reads while draining.
+#define SYMPL_MEM_RELEASE_CLOCK_STRIDE 32
+
+/**
+ * Deferred destruction for objects whose last reference is dropped. Once
+ * enabled on a thread, an object whose count hits zero is queued instead of
+ * destroyed inline, and safe points destroy queued objects within a time
+ * budget. Children released by a destroyed object are queued in turn, so
+ * dropping a large graph costs bounded slices instead of one long cascade.
+ *
+ * Reference counts are not atomic, so objects must be destroyed on the
+ * thread that owns them; there is one queue per thread and no helper thread.
+ */
+class SYMPL_API MemReleaseQueue
+{
+private:
+    // Objects waiting to be destroyed, newest last.
+    std::vector<ManagedObject*> objects;
+
+    // Time a safe point may spend draining.
+    long long slice_budget_ns = SYMPL_MEM_RELEASE_SLICE_BUDGET_NS;
+
+    // Whether a drain is running, so destructors only queue more.
+    bool draining = false;
+
+    // Statistics.
+    size_t peak_depth = 0;
+    size_t num_queued = 0;
+    size_t num_destroyed = 0;
+    size_t num_drains = 0;
+    long long last_drain_ns = 0;
+    long long max_drain_ns = 0;
+
+    // Queue objects are deferred to on this thread, nullptr while deferral is off.
+    static thread_local MemReleaseQueue* active_queue;
+
+public:
+    /**
+     * Returns the queue of the calling thread, nullptr while the thread is exiting.
+     * @return
+     */
+    static MemReleaseQueue* instance();
+
+    /**
+     * Returns the calling thread's queue if deferral is enabled on it.
+     * @return
+     */
+    inline static MemReleaseQueue* active() { return active_queue; }
+
+    /**
+     * Turns deferral on or off for the calling thread. Turning it off
+     * destroys everything still queued.
+     * @param p_enabled
+     */
+    void set_enabled(bool p_enabled);
+
+    /**
+     * Returns whether deferral is on for the calling thread.
+     * @return
+     */
+    inline bool is_enabled() const { return active_queue == this; }
+
+    /**
+     * Queues an object whose count hit zero.
+     * @param p_object
+     */
+    inline void push(ManagedObject* p_object)
+    {
+        objects.emplace_back(p_object);
+        num_queued++;
+        if (objects.size() > peak_depth) {
+            peak_depth = objects.size();
+        }
+    }
+
+    /**
+     * Destroys queued objects, and the ones they release, until the queue is
+     * empty or the budget is used. Call where no raw pointers to managed
+     * objects are held outside of shared pointers.
+     * @param p_budget_ns Time budget, 0 for no limit.
+     * @return Objects destroyed.
+     */
+    size_t drain(long long p_budget_ns = 0);
+
+    /**
+     * Drains within the slice budget if anything is queued.
+     */
+    inline void safe_point()
+    {
+        if (!objects.empty()) {
+            drain(slice_budget_ns);
+        }
+    }
+
+    /**
+     * Forgets every queued object living in a pool that is about to drop its blocks.
+     * @param p_pool
+     */
+    void remove_objects(const MemPool* p_pool);
+
+    /**
+     * Sets the time a safe point may spend draining.
+     * @param p_slice_budget_ns
+     */
+    inline void set_slice_budget(long long p_slice_budget_ns) { slice_budget_ns = p_slice_budget_ns; }
+
+    /**
+     * Returns the time a safe point may spend draining.
+     * @return
+     */
+    inline long long get_slice_budget() const { return slice_budget_ns; }
+
+    /**
+     * Returns the number of objects waiting to be destroyed.
+     * @return
+     */
+    inline size_t get_depth() const { return objects.size(); }
+
+    /**
+     * Returns the most objects ever waiting at once.
+     * @return
+     */
+    inline size_t get_peak_depth() const { return peak_depth; }
+
+    /**
+     * Returns the number of objects queued so far.
+     * @return
+     */
+    inline size_t get_num_queued() const { return num_queued; }
+
+    /**
+     * Returns the number of queued objects destroyed so far.
+     * @return
+     */
+    inline size_t get_num_destroyed() const { return num_destroyed; }
+
+    /**
+     * Returns the number of drains run.
+     * @return
+     */
+    inline size_t get_num_drains() const { return num_drains; }
+
+    /**
+     * Returns how long the last drain took, in nanoseconds.
+     * @return
+     */
+    inline long long get_last_drain_ns() const { return last_drain_ns; }
+
+    /**
+     * Returns the longest drain so far, in nanoseconds.
+     * @return
+     */
+    inline long long get_max_drain_ns() const { return max_drain_ns; }
+};
+
+SymplNamespaceEnd
@@ -0,0 +1,76 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#include "mem_scratch_arena.hpp"
+#include "mem_arena.hpp"
+#include "managed_object.hpp"
+SymplNamespace
+
+thread_local MemScratchArena* MemScratchArena::current_arena = nullptr;
+
+MemScratchArena::~MemScratchArena()
+{
+    reset();
+    for (auto& chunk : chunks) {
+        MemArena::unmap_memory(chunk.base, chunk.size);
+    }
+}
+
+bool MemScratchArena::next_chunk(size_t p_size)
+{
+    // Reuse the chunks left from earlier frames before mapping more.
+    while (!chunks.empty() && chunk_index + 1 < chunks.size()) {
+        chunk_index++;
+        if (chunks[chunk_index].size >= p_size) {
+            return true;
+        }
+    }
+
+    Chunk chunk;
+    chunk.size = std::max(chunk_size, (p_size + SYMPL_MEM_ARENA_PAGE_SIZE - 1) & ~static_cast<size_t>(SYMPL_MEM_ARENA_PAGE_SIZE - 1));
+    chunk.base = MemArena::map_memory(chunk.size, false);
+    if (!chunk.base) {
+        return false;
+    }
+
+    chunks.emplace_back(chunk);
+    chunk_index = chunks.size() - 1;
+    return true;
+}
+
+void MemScratchArena::reset()
+{
+    // Newest first, so an object usually goes before the older ones it points at.
+    // Releases between scratch objects only touch counts, so the order is not load bearing.
+    for (size_t i = objects.size(); i > 0; --i) {
+        ManagedObject* object = objects[i - 1];
+        object->__destruct();
+        object->~ManagedObject();
+    }
+    objects.clear();
+
+    peak_bytes = std::max(peak_bytes, used_bytes);
+    used_bytes = 0;
+    chunk_index = 0;
+    offset = 0;
+}
+
+void MemScratchArena::shrink()
+{
+    reset();
+    for (size_t i = 1; i < chunks.size(); ++i) {
+        MemArena::unmap_memory(chunks[i].base, chunks[i].size);
+    }
+    if (chunks.size() > 1) {
+        chunks.resize(1);
+    }
+}
+
+size_t MemScratchArena::get_reserved_bytes() const
+{
+    size_t reserved = 0;
+    for (const auto& chunk : chunks) {
+        reserved += chunk.size;
+    }
+    return reserved;
+}
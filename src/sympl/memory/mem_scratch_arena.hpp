@@ -0,0 +1,178 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include <sympl/sympl_pch.hpp>
+
+SymplNamespaceStart
+
+class ManagedObject;
+
+// Default size of a scratch chunk.
+#define SYMPL_MEM_SCRATCH_CHUNK_SIZE (64 * 1024)
+
+/**
+ * Bump allocator for temporaries that die within a frame. Objects made with
+ * ManagedObject::make_scratch cost a pointer bump, their references never
+ * free anything, and reset() drops them all at once. Anything that outlives
+ * the frame must be promoted to the heap with ManagedObject::promote first.
+ * Not thread safe, each thread runs its own frames.
+ */
+class SYMPL_API MemScratchArena
+{
+    friend class MemScratchScope;
+
+private:
+    /**
+     * Run of memory carved by bumping an offset.
+     */
+    struct Chunk
+    {
+        StrPtr base = nullptr;
+        size_t size = 0;
+    };
+
+    // Chunks mapped so far, kept across resets.
+    std::vector<Chunk> chunks;
+
+    // Chunk being carved and the offset into it.
+    size_t chunk_index = 0;
+    size_t offset = 0;
+
+    // Size of newly mapped chunks.
+    size_t chunk_size = SYMPL_MEM_SCRATCH_CHUNK_SIZE;
+
+    // Objects made this frame, destructed in reverse on reset.
+    std::vector<ManagedObject*> objects;
+
+    // Bytes carved this frame and the most carved in one frame.
+    size_t used_bytes = 0;
+    size_t peak_bytes = 0;
+
+    // Arena objects are made in on this thread, nullptr for none.
+    static thread_local MemScratchArena* current_arena;
+
+    /**
+     * Moves to the next chunk that fits a request, mapping one if needed.
+     * @param p_size
+     * @return false if the OS is out of memory.
+     */
+    bool next_chunk(size_t p_size);
+
+public:
+    /**
+     * Constructor.
+     * @param p_chunk_size
+     */
+    explicit MemScratchArena(size_t p_chunk_size = SYMPL_MEM_SCRATCH_CHUNK_SIZE) : chunk_size(p_chunk_size) {}
+
+    /**
+     * Destructor. Resets the arena and unmaps its chunks.
+     */
+    ~MemScratchArena();
+
+    MemScratchArena(const MemScratchArena&) = delete;
+    MemScratchArena& operator=(const MemScratchArena&) = delete;
+
+    /**
+     * Carves memory for an object.
+     * @param p_size
+     * @param p_alignment Power of two.
+     * @return nullptr if the OS is out of memory.
+     */
+    inline void* allocate(size_t p_size, size_t p_alignment)
+    {
+        if (!chunks.empty()) {
+            size_t start = (offset + p_alignment - 1) & ~(p_alignment - 1);
+            if (start + p_size <= chunks[chunk_index].size) {
+                offset = start + p_size;
+                used_bytes += p_size;
+                return chunks[chunk_index].base + start;
+            }
+        }
+
+        // Chunk bases are page aligned, so a fresh chunk fits any alignment.
+        if (!next_chunk(p_size)) {
+            return nullptr;
+        }
+        offset = p_size;
+        used_bytes += p_size;
+        return chunks[chunk_index].base;
+    }
+
+    /**
+     * Records an object to destruct on reset.
+     * @param p_object
+     */
+    inline void add_object(ManagedObject* p_object) { objects.emplace_back(p_object); }
+
+    /**
+     * Destructs every object made since the last reset and starts carving
+     * from the first chunk again. Scratch objects may still reference each
+     * other, but nothing outside the frame may reference them.
+     */
+    void reset();
+
+    /**
+     * Unmaps every chunk past the first, after a frame that needed more than usual.
+     */
+    void shrink();
+
+    /**
+     * Returns the number of objects made since the last reset.
+     * @return
+     */
+    inline size_t get_num_objects() const { return objects.size(); }
+
+    /**
+     * Returns the bytes carved since the last reset.
+     * @return
+     */
+    inline size_t get_used_bytes() const { return used_bytes; }
+
+    /**
+     * Returns the most bytes carved in one frame.
+     * @return
+     */
+    inline size_t get_peak_bytes() const { return std::max(peak_bytes, used_bytes); }
+
+    /**
+     * Returns the bytes mapped for chunks.
+     * @return
+     */
+    size_t get_reserved_bytes() const;
+
+    /**
+     * Returns the arena scratch objects are made in on the calling thread, nullptr for none.
+     * @return
+     */
+    inline static MemScratchArena* current() { return current_arena; }
+};
+
+/**
+ * Makes an arena the one scratch objects go to on the calling thread until
+ * the scope ends. The host holds one for a frame or a script run.
+ */
+class SYMPL_API MemScratchScope
+{
+private:
+    // Arena that was current before the scope.
+    MemScratchArena* previous_arena = nullptr;
+
+public:
+    /**
+     * Constructor.
+     * @param p_arena
+     */
+    explicit MemScratchScope(MemScratchArena* p_arena) : previous_arena(MemScratchArena::current_arena) { MemScratchArena::current_arena = p_arena; }
+
+    /**
+     * Destructor. Restores the arena that was current before.
+     */
+    ~MemScratchScope() { MemScratchArena::current_arena = previous_arena; }
+
+    MemScratchScope(const MemScratchScope&) = delete;
+    MemScratchScope& operator=(const MemScratchScope&) = delete;
+};
+
+SymplNamespaceEnd
@@ -0,0 +1,103 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include "mem_block.hpp"
+
+SymplNamespaceStart
+
+// Smallest block size handed out by the pool.
+#define SYMPL_MEM_POOL_MIN_BLOCK_SIZE 16
+// Number of power-of-two size classes (16 bytes up to 32 GB).
+#define SYMPL_MEM_POOL_NUM_SIZE_CLASSES 32
+// Total number of size classes, including the per-type slab classes. Block size
+// classes are stored in a byte, and the last value marks large blocks.
+#define SYMPL_MEM_POOL_MAX_SIZE_CLASSES 255
+
+/**
+ * Free list for blocks of a single size class.
+ */
+struct SYMPL_API MemSizeClass
+{
+    // Size of every block in this class.
+    size_t block_size = 0;
+
+    // Head of the intrusive free list (linked through MemBlock::next_free).
+    MemBlock* free_list = nullptr;
+
+    // Number of blocks in the free list.
+    size_t free_count = 0;
+
+    // Blocks moved per refill or flush, cached to keep the division off the hot path.
+    size_t batch_size = 0;
+
+    // Blocks handed out minus blocks returned. Only the owner writes it.
+    std::atomic<long long> live_count{0};
+
+    // Highest live count seen. A thread cache tracks its own count, the central
+    // class the pool-wide count folded in under the central lock.
+    std::atomic<long long> peak_count{0};
+
+    /**
+     * Pushes a block onto the free list.
+     * @param p_block
+     */
+    inline void push(MemBlock* p_block)
+    {
+        p_block->next_free = free_list;
+        free_list = p_block;
+        free_count++;
+    }
+
+    /**
+     * Pops a block from the free list.
+     * @return
+     */
+    inline MemBlock* pop()
+    {
+        MemBlock* block = free_list;
+        if (!block) {
+            return nullptr;
+        }
+
+        free_list = block->next_free;
+        free_count--;
+        block->next_free = nullptr;
+        return block;
+    }
+
+    /**
+     * Adjusts the live count. Only the owner of the class may call this.
+     * @param p_delta
+     * @return The new live count.
+     */
+    inline long long add_live(long long p_delta)
+    {
+        long long count = live_count.load(std::memory_order_relaxed) + p_delta;
+        live_count.store(count, std::memory_order_relaxed);
+        return count;
+    }
+
+    /**
+     * Raises the peak to a count. Only the owner of the class may call this.
+     * @param p_count
+     */
+    inline void raise_peak(long long p_count)
+    {
+        if (p_count > peak_count.load(std::memory_order_relaxed)) {
+            peak_count.store(p_count, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Drops every block from the free list.
+     */
+    inline void reset()
+    {
+        free_list = nullptr;
+        free_count = 0;
+        live_count.store(0, std::memory_order_relaxed);
+    }
+};
+
+SymplNamespaceEnd
@@ -0,0 +1,56 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#include "mem_thread_cache.hpp"
+#include "mem_pool.hpp"
+SymplNamespace
+
+MemThreadCache::MemThreadCache(MemPool* p_pool)
+{
+    pool = p_pool;
+}
+
+MemBlock* MemThreadCache::pop_block(size_t p_class_index)
+{
+    MemSizeClass& size_class = size_classes[p_class_index];
+    if (!size_class.free_list) {
+        pool->refill_thread_cache(this, p_class_index);
+    }
+
+    MemBlock* block = size_class.pop();
+    if (block) {
+        size_class.raise_peak(size_class.add_live(1));
+        live_blocks.store(live_blocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        live_bytes.store(live_bytes.load(std::memory_order_relaxed) + static_cast<long long>(block->block_size), std::memory_order_relaxed);
+    }
+    return block;
+}
+
+void MemThreadCache::push_block(MemBlock* p_block, size_t p_class_index)
+{
+    MemSizeClass& size_class = size_classes[p_class_index];
+    size_class.push(p_block);
+    size_class.add_live(-1);
+    live_blocks.store(live_blocks.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    live_bytes.store(live_bytes.load(std::memory_order_relaxed) - static_cast<long long>(p_block->block_size), std::memory_order_relaxed);
+
+    if (size_class.batch_size == 0) {
+        size_class.batch_size = MemPool::get_cache_batch_size(p_class_index);
+    }
+
+    // Keep one batch around for the next allocations and hand the rest back.
+    if (size_class.free_count > size_class.batch_size * 2) {
+        pool->flush_thread_cache(this, p_class_index, size_class.batch_size);
+    }
+}
+
+void MemThreadCache::reset()
+{
+    for (auto& size_class : size_classes) {
+        size_class.reset();
+        size_class.peak_count.store(0, std::memory_order_relaxed);
+    }
+
+    live_blocks.store(0, std::memory_order_relaxed);
+    live_bytes.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,58 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include "mem_size_class.hpp"
+
+SymplNamespaceStart
+
+class MemPool;
+
+/**
+ * Per-thread magazine of free blocks sitting in front of a MemPool.
+ * Only the owning thread touches the free lists; the central pool is
+ * locked once per batch on refill and flush.
+ */
+class SYMPL_API MemThreadCache
+{
+    friend class MemPool;
+
+private:
+    // Pool the cache refills from and flushes to.
+    MemPool* pool;
+
+    // Thread-local free lists, one per size class.
+    MemSizeClass size_classes[SYMPL_MEM_POOL_MAX_SIZE_CLASSES];
+
+    // Blocks allocated minus blocks freed on this thread. Only the owning thread writes them.
+    std::atomic<long long> live_blocks{0};
+    std::atomic<long long> live_bytes{0};
+
+public:
+    /**
+     * Constructor.
+     * @param p_pool
+     */
+    explicit MemThreadCache(MemPool* p_pool);
+
+    /**
+     * Pops a free block, refilling from the central pool when empty.
+     * @param p_class_index
+     * @return
+     */
+    MemBlock* pop_block(size_t p_class_index);
+
+    /**
+     * Pushes a free block, flushing a batch to the central pool when full.
+     * @param p_block
+     * @param p_class_index
+     */
+    void push_block(MemBlock* p_block, size_t p_class_index);
+
+    /**
+     * Drops every cached block without returning it to the pool.
+     */
+    void reset();
+};
+
+SymplNamespaceEnd
@@ -7,6 +7,10 @@
 
 SymplNamespaceStart
 
+// Reference count pinned on immortal objects. Far past anything a real count
+// reaches, so add_ref and release only need to compare against it.
+#define SYMPL_OBJECT_IMMORTAL_REF_COUNT (1LL << 62)
+
 class SYMPL_API ObjectRef
 {
 public:
@@ -26,12 +30,10 @@ public:
 	 */
 	void add_ref()
 	{
-		if (mem_block && mem_block->is_static) {
-			ref_count = 1;
+		// Immortal objects keep their pinned count.
+		if (ref_count < SYMPL_OBJECT_IMMORTAL_REF_COUNT) {
+			ref_count++;
 		}
-
-		// Increment the reference count
-		ref_count++;
 	}
 
 	/**
@@ -40,7 +42,7 @@ public:
 	 */
 	virtual int release()
 	{
-		if (mem_block && mem_block->is_static) {
+		if (ref_count >= SYMPL_OBJECT_IMMORTAL_REF_COUNT) {
 			return 1;
 		}
 
@@ -49,6 +51,12 @@ public:
 		return --ref_count;
 	}
 
+	/**
+	 * Returns whether the object is never freed.
+	 * @return
+	 */
+	inline bool is_immortal() const { return ref_count >= SYMPL_OBJECT_IMMORTAL_REF_COUNT; }
+
 	/**
 	 * Overloads the equal operator.
 	 * @param rhs
@@ -77,13 +85,39 @@ public:
 	//! \return RefInfo
 	static const ObjectRefInfo* get_type_info_static() { return nullptr; }
 
-	//! Casts to another value.
+	//! Check if the object is a T or derives from it.
+	//! \tparam T
+	//! \return
+	template<class T>
+	inline bool is_type_of() const {
+		return has_type_info<T>(nullptr) ? get_type_info()->is_type_of(T::get_type_info_static()) : dynamic_cast<const T*>(this) != nullptr;
+	}
+
+	//! Casts to another value, nullptr if the value is not a T.
 	//! \tparam T
 	//! \param p_cast_value
 	//! \return
 	template<class T>
 	static T* cast_to(ObjectRef* p_cast_value) {
-		return dynamic_cast<T*>(p_cast_value);
+		if (!p_cast_value) {
+			return nullptr;
+		}
+		return p_cast_value->is_type_of<T>() ? static_cast<T*>(p_cast_value) : nullptr;
+	}
+
+private:
+	//! Whether T declares its own type info with SYMPL_OBJECT, rather than
+	//! inheriting its base's. Other types are checked with dynamic_cast.
+	//! \tparam T
+	//! \return
+	template<class T>
+	static constexpr bool has_type_info(typename T::ClassName*) {
+		return std::is_same<typename T::ClassName, T>::value;
+	}
+
+	template<class T>
+	static constexpr bool has_type_info(...) {
+		return false;
 	}
 };
 
@@ -4,14 +4,43 @@
 #include "object_ref_info.hpp"
 SymplNamespace
 
+namespace {
+	// Id handed to the next type registered.
+	std::atomic<unsigned short> next_type_id(1);
+
+	// Every type registered, by id.
+	std::atomic<const ObjectRefInfo*> type_infos[65536];
+}
+
 ObjectRefInfo::ObjectRefInfo(const char* p_type_name, const ObjectRefInfo* p_base_type_info)
 		:   _type_name(p_type_name),
-			_base_type_info(p_base_type_info)
+			_base_type_info(p_base_type_info),
+			_slab_class_index(-1)
 {
+	// Bases are registered first, since their info is built to construct ours.
+	_type_id = next_type_id.fetch_add(1, std::memory_order_relaxed);
+	_depth = p_base_type_info ? static_cast<unsigned short>(p_base_type_info->_depth + 1) : 0;
+
+	memset(_ancestor_ids, 0, sizeof(_ancestor_ids));
+	if (p_base_type_info) {
+		memcpy(_ancestor_ids, p_base_type_info->_ancestor_ids, sizeof(_ancestor_ids));
+	}
+	if (_depth < SYMPL_OBJECT_MAX_TYPE_DEPTH) {
+		_ancestor_ids[_depth] = _type_id;
+	}
 
+	type_infos[_type_id].store(this, std::memory_order_release);
 }
 
-ObjectRefInfo::~ObjectRefInfo() = default;
+ObjectRefInfo::~ObjectRefInfo()
+{
+	type_infos[_type_id].store(nullptr, std::memory_order_release);
+}
+
+const ObjectRefInfo* ObjectRefInfo::find_type_info(unsigned short p_type_id)
+{
+	return type_infos[p_type_id].load(std::memory_order_acquire);
+}
 
 bool ObjectRefInfo::is_type_of(std::string type) const
 {
@@ -28,7 +57,7 @@ bool ObjectRefInfo::is_type_of(std::string type) const
 	return false;
 }
 
-bool ObjectRefInfo::is_type_of(const ObjectRefInfo* p_type_info) const
+bool ObjectRefInfo::is_deep_type_of(const ObjectRefInfo* p_type_info) const
 {
 	const ObjectRefInfo* current = this;
 
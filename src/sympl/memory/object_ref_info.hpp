@@ -6,6 +6,9 @@
 
 SymplNamespaceStart
 
+// Deepest inheritance chain with constant time type checks. Deeper types fall back to walking the chain.
+#define SYMPL_OBJECT_MAX_TYPE_DEPTH 16
+
 class SYMPL_API ObjectRefInfo {
 private:
 	/// Type name.
@@ -14,6 +17,18 @@ private:
 	/// Base class type info.
 	const ObjectRefInfo* _base_type_info;
 
+	/// Pool size class dedicated to this type, -1 until the first allocation.
+	mutable std::atomic<int> _slab_class_index;
+
+	/// Unique id of the type, starting at 1.
+	unsigned short _type_id;
+
+	/// Number of types above this one in the chain.
+	unsigned short _depth;
+
+	/// Ids of this type and its bases, indexed by depth.
+	unsigned short _ancestor_ids[SYMPL_OBJECT_MAX_TYPE_DEPTH];
+
 public:
 	//! Constructor.
 	//! \param p_type_name
@@ -28,10 +43,25 @@ public:
 	//! \return bool
 	bool is_type_of(std::string type) const;
 
-	//! Check current type is type of specified type.
+	//! Check current type is type of specified type. The ancestor at the
+	//! other type's depth is compared by id, so no chain is walked.
+	//! \param p_type_info
+	//! \return bool
+	inline bool is_type_of(const ObjectRefInfo* p_type_info) const
+	{
+		if (!p_type_info) {
+			return false;
+		}
+		if (p_type_info->_depth < SYMPL_OBJECT_MAX_TYPE_DEPTH) {
+			return _depth >= p_type_info->_depth && _ancestor_ids[p_type_info->_depth] == p_type_info->_type_id;
+		}
+		return is_deep_type_of(p_type_info);
+	}
+
+	//! Check current type is type of specified type by walking the base chain.
 	//! \param p_type_info
 	//! \return bool
-	bool is_type_of(const ObjectRefInfo* p_type_info) const;
+	bool is_deep_type_of(const ObjectRefInfo* p_type_info) const;
 
 	//! Check current type is type of specified class type.
 	//! \return bool
@@ -41,8 +71,23 @@ public:
 	/// Return type name.
 	inline const std::string& get_type_name() const { return _type_name;}
 
+	/// Return the unique id of the type.
+	inline unsigned short get_type_id() const { return _type_id; }
+
+	/// Return the number of types above this one in the chain.
+	inline unsigned short get_depth() const { return _depth; }
+
 	/// Return base type info.
 	inline const ObjectRefInfo* get_base_type_info() const { return _base_type_info; }
+
+	/// Return the type with a given id, nullptr if there is none.
+	static const ObjectRefInfo* find_type_info(unsigned short p_type_id);
+
+	/// Return the pool size class dedicated to this type, -1 if not assigned yet.
+	inline int get_slab_class_index() const { return _slab_class_index.load(std::memory_order_acquire); }
+
+	/// Set the pool size class dedicated to this type.
+	inline void set_slab_class_index(int p_class_index) const { _slab_class_index.store(p_class_index, std::memory_order_release); }
 };
 
 #define SYMPL_OBJECT(type_name, base_type_name) \
@@ -0,0 +1,98 @@
+//
+// GameSencha, LLC 10/18/26.
+//
+#pragma once
+#include "shared_ptr.hpp"
+
+SymplNamespaceStart
+
+/**
+ * Borrowed pointer to a managed object. It never touches the reference count,
+ * so passing one down a call chain costs a register instead of an add_ref and
+ * a virtual release per call. The caller must keep the object alive, through
+ * a SharedPtr it holds, for as long as the borrow is used. Call share() when
+ * the object escapes, e.g. when it is stored or returned past the owner.
+ * @tparam T
+ */
+template<typename T>
+class Ref
+{
+    template<class R>
+    friend class Ref;
+
+private:
+    // Borrowed object.
+    T* ptr_data = nullptr;
+
+public:
+    /**
+     * Constructor.
+     */
+    Ref() noexcept = default;
+
+    /**
+     * Constructor.
+     * @param p_value
+     */
+    Ref(T* p_value) noexcept : ptr_data(p_value) {}
+
+    /**
+     * Constructor. Borrows the object a shared pointer holds.
+     * @param p_shared_ptr
+     */
+    Ref(const SharedPtr<T>& p_shared_ptr) noexcept : ptr_data(p_shared_ptr.ptr()) {}
+
+    /**
+     * Constructor. Borrows the object a shared pointer to a derived type holds.
+     * @param p_shared_ptr
+     */
+    template<class R, class = typename std::enable_if<std::is_convertible<R*, T*>::value>::type>
+    Ref(const SharedPtr<R>& p_shared_ptr) noexcept : ptr_data(p_shared_ptr.ptr()) {}
+
+    /**
+     * Constructor from a borrow of a derived type.
+     * @param p_ref
+     */
+    template<class R, class = typename std::enable_if<std::is_convertible<R*, T*>::value>::type>
+    Ref(const Ref<R>& p_ref) noexcept : ptr_data(p_ref.ptr_data) {}
+
+    /**
+     * Overloads the pointer operator.
+     * @return
+     */
+    inline T& operator*() const { return *ptr_data; }
+
+    /**
+     * Overloads the pointer access operator.
+     * @return
+     */
+    inline T* operator->() const { return ptr_data; }
+
+    /**
+     * Returns the borrowed object.
+     * @return
+     */
+    inline T* ptr() const { return ptr_data; }
+
+    /**
+     * Returns whether the borrow points at an object.
+     * @return
+     */
+    inline bool is_valid() const { return ptr_data != nullptr; }
+
+    /**
+     * Takes a reference of its own, for an object that outlives the borrow.
+     * @return
+     */
+    inline SharedPtr<T> share() const { return SharedPtr<T>(ptr_data); }
+
+    /**
+     * Compares the borrowed objects.
+     * @param p_ref
+     * @return
+     */
+    inline bool operator==(const Ref<T>& p_ref) const { return ptr_data == p_ref.ptr_data; }
+    inline bool operator!=(const Ref<T>& p_ref) const { return ptr_data != p_ref.ptr_data; }
+};
+
+SymplNamespaceEnd
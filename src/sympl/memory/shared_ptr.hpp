@@ -10,6 +10,9 @@ SymplNamespaceStart
 template<typename T>
 class SharedPtr
 {
+    template<class R>
+    friend class SharedPtr;
+
     template<class R>
     friend class WeakPtr;
 
@@ -17,11 +20,16 @@ private:
 	// Pointer reference.
 	ObjectRef* ptr_data = nullptr;
 
+    /**
+     * Drops the reference held, freeing the block when it was the last one.
+     */
+    void release_ref();
+
 public:
 	/**
 	 * Constructor.
 	 */
-	SharedPtr();
+	SharedPtr() noexcept;
 
 	/**
 	 * Constructor.
@@ -35,6 +43,26 @@ public:
 	 */
 	SharedPtr(const SharedPtr<T>& p_copy_shared_ptr);
 
+    /**
+     * Constructor. Takes over the reference without touching the count.
+     * @param p_move_shared_ptr
+     */
+    SharedPtr(SharedPtr<T>&& p_move_shared_ptr) noexcept;
+
+    /**
+     * Constructor from a pointer to a derived type.
+     * @param p_copy_shared_ptr
+     */
+    template<class R, class = typename std::enable_if<std::is_convertible<R*, T*>::value>::type>
+    SharedPtr(const SharedPtr<R>& p_copy_shared_ptr);
+
+    /**
+     * Constructor from a pointer to a derived type. Takes over the reference without touching the count.
+     * @param p_move_shared_ptr
+     */
+    template<class R, class = typename std::enable_if<std::is_convertible<R*, T*>::value>::type>
+    SharedPtr(SharedPtr<R>&& p_move_shared_ptr) noexcept;
+
 	/**
 	 * Destructor.
 	 */
@@ -60,14 +88,33 @@ public:
 	 * @return
 	 */
 	SharedPtr<T>& operator = (const SharedPtr<T>& p_ptr);
+    SharedPtr<T>& operator = (SharedPtr<T>&& p_ptr) noexcept;
     SharedPtr<T>& operator = (T* p_ptr);
 
+    template<class R, class = typename std::enable_if<std::is_convertible<R*, T*>::value>::type>
+    SharedPtr<T>& operator = (const SharedPtr<R>& p_ptr);
+
+    template<class R, class = typename std::enable_if<std::is_convertible<R*, T*>::value>::type>
+    SharedPtr<T>& operator = (SharedPtr<R>&& p_ptr) noexcept;
+
 	/**
 	 * Returns the pointer data.
 	 * @return
 	 */
 	inline T* ptr() const { return static_cast<T*>(ptr_data); }
 
+	/**
+	 * Gives up the pointer without releasing it. The reference is then held by
+	 * the object's heap, for roots of a heap that is dropped as a whole.
+	 * @return
+	 */
+	inline T* detach() noexcept
+	{
+		T* data = ptr();
+		ptr_data = nullptr;
+		return data;
+	}
+
 	/**
 	 * Returns the current count.
 	 * @return
@@ -82,7 +129,7 @@ public:
 };
 
 template<typename T>
-SharedPtr<T>::SharedPtr()
+SharedPtr<T>::SharedPtr() noexcept
 {
     ptr_data = nullptr;
 }
@@ -99,40 +146,68 @@ SharedPtr<T>::SharedPtr(T* p_value)
 template<typename T>
 SharedPtr<T>::SharedPtr(const SharedPtr<T> &p_copy_shared_ptr)
 {
+    ptr_data = p_copy_shared_ptr.ptr_data;
     if (ptr_data) {
-        ptr_data->release();
+        ptr_data->add_ref();
     }
+}
+
+template<typename T>
+SharedPtr<T>::SharedPtr(SharedPtr<T>&& p_move_shared_ptr) noexcept
+{
+    ptr_data = p_move_shared_ptr.ptr_data;
+    p_move_shared_ptr.ptr_data = nullptr;
+}
 
+template<typename T>
+template<class R, class>
+SharedPtr<T>::SharedPtr(const SharedPtr<R>& p_copy_shared_ptr)
+{
     ptr_data = p_copy_shared_ptr.ptr_data;
     if (ptr_data) {
         ptr_data->add_ref();
     }
 }
 
+template<typename T>
+template<class R, class>
+SharedPtr<T>::SharedPtr(SharedPtr<R>&& p_move_shared_ptr) noexcept
+{
+    ptr_data = p_move_shared_ptr.ptr_data;
+    p_move_shared_ptr.ptr_data = nullptr;
+}
+
 template<typename T>
 SharedPtr<T>::~SharedPtr()
+{
+    release_ref();
+}
+
+template<typename T>
+void SharedPtr<T>::release_ref()
 {
     if (ptr_data && ptr_data->ref_count <= 0) {
+        ptr_data = nullptr;
         return;
     }
 
-	if (ptr_data && ptr_data->release() == 0)
-	{
-		MemPool::instance()->free_block(ptr_data->mem_block);
-        ptr_data = nullptr;
-	}
+    // The object frees its own block on the last release, and may be unmapped by the time it returns.
+    if (ptr_data) {
+        ptr_data->release();
+    }
+    ptr_data = nullptr;
 }
 
 template<typename T>
 T& SharedPtr<T>::operator*()
 {
-	return *ptr_data;
+	return *ptr();
 }
 
 template<typename T>
 const T& SharedPtr<T>::operator*() const
 {
-    return *ptr_data;
+    return *ptr();
 }
 
 template<typename T>
@@ -150,54 +225,94 @@ const T* SharedPtr<T>::operator->() const
 template<typename T>
 SharedPtr<T> &SharedPtr<T>::operator=(const SharedPtr<T> &p_ptr)
 {
-	if (this == &p_ptr)
+    // Already holding a reference to the same data.
+	if (ptr_data == p_ptr.ptr_data)
 	{
 		return *this;
 	}
 
-    if (ptr_data && ptr_data == p_ptr.ptr_data) {
-        ptr_data->add_ref();
+    // Take the new reference first so releasing ours can't free what we copy.
+    ObjectRef* data = p_ptr.ptr_data;
+    if (data) {
+        data->add_ref();
+    }
+
+    release_ref();
+	ptr_data = data;
+
+	return *this;
+}
+
+template<typename T>
+SharedPtr<T> &SharedPtr<T>::operator=(SharedPtr<T>&& p_ptr) noexcept
+{
+    if (this == &p_ptr) {
         return *this;
     }
 
-	// Check if we need to delete the data.
-	if(ptr_data && ptr_data->mem_block && !ptr_data->mem_block->is_static && ptr_data->release() == 0)
-	{
-		MemPool::instance()->free_block(ptr_data->mem_block);
-	}
+    release_ref();
+    ptr_data = p_ptr.ptr_data;
+    p_ptr.ptr_data = nullptr;
 
-	// Copy over our data.
-	ptr_data = p_ptr.ptr_data;
+    return *this;
+}
 
-    if (ptr_data) {
-        ptr_data->add_ref();
+template<typename T>
+template<class R, class>
+SharedPtr<T> &SharedPtr<T>::operator=(const SharedPtr<R>& p_ptr)
+{
+    if (ptr_data == p_ptr.ptr_data) {
+        return *this;
     }
 
-	return *this;
+    ObjectRef* data = p_ptr.ptr_data;
+    if (data) {
+        data->add_ref();
+    }
+
+    release_ref();
+    ptr_data = data;
+
+    return *this;
 }
 
 template<typename T>
-SharedPtr<T> &SharedPtr<T>::operator=(T* p_ptr)
+template<class R, class>
+SharedPtr<T> &SharedPtr<T>::operator=(SharedPtr<R>&& p_ptr) noexcept
 {
-    // Check if we need to delete the data.
-    if(ptr_data && ptr_data != p_ptr && ptr_data->release() == 0)
-    {
-        MemPool::instance()->free_block(ptr_data->mem_block);
-        ptr_data = nullptr;
+    ObjectRef* data = p_ptr.ptr_data;
+    p_ptr.ptr_data = nullptr;
+
+    // Moving a second reference to the same data in just drops one of them.
+    if (ptr_data == data) {
+        if (data) {
+            data->release();
+        }
+        return *this;
     }
 
-    if (ptr_data && ptr_data == p_ptr) {
-        ptr_data->add_ref();
+    release_ref();
+    ptr_data = data;
+
+    return *this;
+}
+
+template<typename T>
+SharedPtr<T> &SharedPtr<T>::operator=(T* p_ptr)
+{
+    if (ptr_data == p_ptr) {
         return *this;
     }
 
-    // Copy over our data.
-    ptr_data = p_ptr;
-    if (ptr_data) {
-        ptr_data->add_ref();
+    ObjectRef* data = p_ptr;
+    if (data) {
+        data->add_ref();
     }
 
+    release_ref();
+    ptr_data = data;
+
     return *this;
 }
 
-SymplNamespaceEnd
\ No newline at end of file
+SymplNamespaceEnd
@@ -9,15 +9,55 @@ SymplNamespaceStart
 template<typename T>
 class WeakPtr
 {
+    template<class R>
+    friend class WeakPtr;
+
 private:
     // Pointer reference.
     ObjectRef* ptr_data = nullptr;
 
+    // Pool the object lived in when the pointer was taken, nullptr for objects made outside one.
+    MemPool* pool = nullptr;
+
+    // Handle to the object's block, resolved through the pool to check liveness.
+    MemHandle handle;
+
+    /**
+     * Points at an object and takes a handle to its block.
+     * @param p_ptr_data
+     */
+    inline void bind(ObjectRef* p_ptr_data) noexcept
+    {
+        MemBlock* block = p_ptr_data ? p_ptr_data->mem_block : nullptr;
+        MemPool* block_pool = block ? block->pool : nullptr;
+        assign(p_ptr_data, block_pool, block_pool ? MemHandle(block->block_index, block->generation.load(std::memory_order_relaxed), block_pool->get_heap_id()) : MemHandle());
+    }
+
+    /**
+     * Copies another weak pointer's reference.
+     * @param p_ptr_data
+     * @param p_pool
+     * @param p_handle
+     */
+    inline void assign(ObjectRef* p_ptr_data, MemPool* p_pool, MemHandle p_handle) noexcept
+    {
+        if (p_pool) {
+            p_pool->add_weak_ref();
+        }
+        if (pool) {
+            pool->release_weak_ref();
+        }
+
+        ptr_data = p_ptr_data;
+        pool = p_pool;
+        handle = p_handle;
+    }
+
 public:
     /**
      * Constructor.
      */
-    WeakPtr();
+    WeakPtr() noexcept;
 
     /**
      * Constructor.
@@ -31,6 +71,26 @@ public:
      */
     WeakPtr(const WeakPtr<T>& p_copy_weak_ptr);
 
+    /**
+     * Constructor.
+     * @param p_move_weak_ptr
+     */
+    WeakPtr(WeakPtr<T>&& p_move_weak_ptr) noexcept;
+
+    /**
+     * Constructor from a weak pointer to a derived type.
+     * @param p_copy_weak_ptr
+     */
+    template<class R, class = typename std::enable_if<std::is_convertible<R*, T*>::value>::type>
+    WeakPtr(const WeakPtr<R>& p_copy_weak_ptr) noexcept;
+
+    /**
+     * Constructor from a shared pointer to the same or a derived type.
+     * @param p_shared_ptr
+     */
+    template<class R, class = typename std::enable_if<std::is_convertible<R*, T*>::value>::type>
+    WeakPtr(const SharedPtr<R>& p_shared_ptr) noexcept;
+
     /**
      * Destructor.
      */
@@ -56,30 +116,58 @@ public:
      * @return
      */
     WeakPtr<T>& operator = (const WeakPtr<T>& p_ptr);
+    WeakPtr<T>& operator = (WeakPtr<T>&& p_ptr) noexcept;
     WeakPtr<T>& operator = (const SharedPtr<T>& p_ptr);
     WeakPtr<T>& operator = (T* Ptr);
 
+    template<class R, class = typename std::enable_if<std::is_convertible<R*, T*>::value>::type>
+    WeakPtr<T>& operator = (const WeakPtr<R>& p_ptr) noexcept;
+
+    template<class R, class = typename std::enable_if<std::is_convertible<R*, T*>::value>::type>
+    WeakPtr<T>& operator = (const SharedPtr<R>& p_ptr) noexcept;
+
     /**
-     * Returns the pointer data.
+     * Returns the pointer data. Check is_valid() first, the object may be gone.
      * @return
      */
     inline T* ptr() const { return static_cast<T*>(ptr_data); }
 
+    /**
+     * Returns a shared pointer to the object, or an empty one if it is gone.
+     * @return
+     */
+    inline SharedPtr<T> lock() const { return is_valid() ? SharedPtr<T>(ptr()) : SharedPtr<T>(); }
+
     /**
      * Returns the current count.
      * @return
      */
     inline size_t ref_count() const { return ptr_data->ref_count; }
 
+    /**
+     * Returns whether the object is still alive. Pool objects are resolved through
+     * their pool's handle table, so a freed and reused block, or a cleared pool, is
+     * caught without touching the object itself. A weak pointer must not outlive
+     * its pool; debug builds assert on that when the pool is destroyed.
+     * @return
+     */
+    inline bool is_valid() const
+    {
+        if (pool) {
+            return pool->is_alive(handle);
+        }
+        return ptr_data != nullptr && ptr_data->ref_count > 0;
+    }
+
     /**
      * Returns whether or not the data is valid.
      * @return
      */
-    inline bool is_value() const { return ptr_data != nullptr && ptr_data->ref_count > 0; }
+    inline bool is_value() const { return is_valid(); }
 };
 
 template<typename T>
-WeakPtr<T>::WeakPtr()
+WeakPtr<T>::WeakPtr() noexcept
 {
     ptr_data = nullptr;
 }
@@ -87,35 +175,52 @@ WeakPtr<T>::WeakPtr()
 template<typename T>
 WeakPtr<T>::WeakPtr(T* p_value)
 {
-    ptr_data = p_value;
+    bind(p_value);
 }
 
 template<typename T>
 WeakPtr<T>::WeakPtr(const WeakPtr<T> &p_copy_weak_ptr)
 {
-    ptr_data = p_copy_weak_ptr.ptr_data;
+    assign(p_copy_weak_ptr.ptr_data, p_copy_weak_ptr.pool, p_copy_weak_ptr.handle);
 }
 
 template<typename T>
-WeakPtr<T>::~WeakPtr()
+WeakPtr<T>::WeakPtr(WeakPtr<T>&& p_move_weak_ptr) noexcept
 {
-    if (ptr_data && ptr_data->ref_count <= 0) {
-        return;
-    }
+    assign(p_move_weak_ptr.ptr_data, p_move_weak_ptr.pool, p_move_weak_ptr.handle);
+    p_move_weak_ptr.assign(nullptr, nullptr, MemHandle());
+}
 
-    ptr_data = nullptr;
+template<typename T>
+template<class R, class>
+WeakPtr<T>::WeakPtr(const WeakPtr<R>& p_copy_weak_ptr) noexcept
+{
+    assign(p_copy_weak_ptr.ptr_data, p_copy_weak_ptr.pool, p_copy_weak_ptr.handle);
+}
+
+template<typename T>
+template<class R, class>
+WeakPtr<T>::WeakPtr(const SharedPtr<R>& p_shared_ptr) noexcept
+{
+    bind(p_shared_ptr.ptr_data);
+}
+
+template<typename T>
+WeakPtr<T>::~WeakPtr()
+{
+    assign(nullptr, nullptr, MemHandle());
 }
 
 template<typename T>
 T& WeakPtr<T>::operator*()
 {
-    return *ptr_data;
+    return *ptr();
 }
 
 template<typename T>
 const T& WeakPtr<T>::operator*() const
 {
-    return *ptr_data;
+    return *ptr();
 }
 
 template<typename T>
@@ -138,35 +243,53 @@ WeakPtr<T> &WeakPtr<T>::operator=(const WeakPtr<T> &p_ptr)
         return *this;
     }
 
-    if (ptr_data && ptr_data == p_ptr.ptr_data) {
+    // Copy over our data.
+    assign(p_ptr.ptr_data, p_ptr.pool, p_ptr.handle);
+
+    return *this;
+}
+
+template<typename T>
+WeakPtr<T> &WeakPtr<T>::operator=(WeakPtr<T>&& p_ptr) noexcept
+{
+    if (this == &p_ptr) {
         return *this;
     }
 
-    // Copy over our data.
-    ptr_data = p_ptr.ptr_data;
+    assign(p_ptr.ptr_data, p_ptr.pool, p_ptr.handle);
+    p_ptr.assign(nullptr, nullptr, MemHandle());
 
     return *this;
 }
 
 template<typename T>
-WeakPtr<T>& WeakPtr<T>::operator=(const SharedPtr<T>& p_ptr)
+template<class R, class>
+WeakPtr<T> &WeakPtr<T>::operator=(const WeakPtr<R>& p_ptr) noexcept
 {
-    ptr_data = p_ptr.ptr_data;
+    assign(p_ptr.ptr_data, p_ptr.pool, p_ptr.handle);
     return *this;
 }
 
 template<typename T>
-WeakPtr<T> &WeakPtr<T>::operator=(T* p_ptr)
+template<class R, class>
+WeakPtr<T> &WeakPtr<T>::operator=(const SharedPtr<R>& p_ptr) noexcept
 {
-    // Check if we need to delete the data.
-    if (ptr_data && ptr_data == p_ptr) {
-        return *this;
-    }
+    bind(p_ptr.ptr_data);
+    return *this;
+}
 
-    // Copy over our data.
-    ptr_data = p_ptr;
+template<typename T>
+WeakPtr<T>& WeakPtr<T>::operator=(const SharedPtr<T>& p_ptr)
+{
+    bind(p_ptr.ptr_data);
+    return *this;
+}
 
+template<typename T>
+WeakPtr<T> &WeakPtr<T>::operator=(T* p_ptr)
+{
+    bind(p_ptr);
     return *this;
 }
 
-SymplNamespaceEnd
\ No newline at end of file
+SymplNamespaceEnd
@@ -7,3 +7,13 @@
 #include <sympl/sympl_pch.hpp>
 #include <sympl/memory/mem_block.hpp>
 #include <sympl/memory/mem_pool.hpp>
+#include <sympl/memory/managed_object.hpp>
+#include <sympl/memory/mem_immortal_cache.hpp>
+#include <sympl/memory/mem_scratch_arena.hpp>
+#include <sympl/memory/weak_ptr.hpp>
+#include <sympl/memory/ref.hpp>
+#include <sympl/memory/mem_cycle_collector.hpp>
+#include <sympl/memory/mem_release_queue.hpp>
+#include <sympl/memory/mem_alloc_tracer.hpp>
+#include <sympl/memory/mem_heap_snapshot.hpp>
+#include <sympl/core/string_buffer.hpp>
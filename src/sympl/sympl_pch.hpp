@@ -286,6 +286,7 @@ static const char* ExportFunc = "export";
 static const char* IncludeFunc = "include";
 static const char* RunFunc = "run";
 
-static long long _sympl_object_next_instance_id = 0;
+// Next managed object instance id, shared by every translation unit. Defined in managed_object.cpp.
+extern SYMPL_API std::atomic<long long> _sympl_object_next_instance_id;
 
 SymplNamespaceEnd